@@ -47,6 +47,7 @@ SCIP_DECL_BRANCHEXECLP(branchExeclpMAPF)
     debug_assert(result);
 
     // Branch.
+    TRACE_SCOPE("branch_lp");
     return branch_lp(scip, result);
 }
 #pragma GCC diagnostic pop
@@ -64,6 +65,7 @@ SCIP_DECL_BRANCHEXECPS(branchExecpsMAPF)
     debug_assert(result);
 
     // Branch.
+    TRACE_SCOPE("branch_pseudosolution");
     return branch_pseudosolution(scip, result);
 }
 #pragma GCC diagnostic pop
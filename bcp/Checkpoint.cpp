@@ -0,0 +1,539 @@
+/*
+This file is part of BCP-MAPF.
+
+BCP-MAPF is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+BCP-MAPF is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+Author: Edward Lam <ed@ed-lam.com>
+*/
+
+
+#include "Checkpoint.h"
+#include "ProblemData.h"
+#include "VariableData.h"
+#include "ConstraintHandler_VertexConflicts.h"
+#include "ConstraintHandler_EdgeConflicts.h"
+#ifdef USE_OLD_TIME_SPACING
+#include "ConstraintHandler_OldTimeSpacing.h"
+#endif
+#ifdef USE_NEW_TIME_SPACING
+#include "ConstraintHandler_NewTimeSpacing.h"
+#endif
+#include <fstream>
+
+// A checkpoint is a binary file with the following sections:
+//   Header: magic number, version, number of agents, map dimensions, hash of the obstacles, time-spacing parameter,
+//           and the start and goal of every agent
+//   Columns: agent, path length and path of every column
+//   Incumbent: flag and the index of the column of every agent
+//   Vertex conflicts: node-times
+//   Edge conflicts: number of edges per conflict, then the time and edges of every conflict
+//   Time spacing conflicts: kind of constraint handler and keys
+//   Two-agent robust cuts: separator name, RHS, agents and edge-times
+
+constexpr uint32_t CHECKPOINT_MAGIC = 0x5043434d; // "MCCP"
+constexpr uint32_t CHECKPOINT_VERSION = 2;
+
+enum TimeSpacingKind : uint8_t
+{
+    NO_TIME_SPACING = 0,
+    OLD_TIME_SPACING = 1,
+    NEW_TIME_SPACING = 2
+};
+
+#if defined(USE_NEW_TIME_SPACING)
+constexpr TimeSpacingKind TIME_SPACING_KIND = NEW_TIME_SPACING;
+#elif defined(USE_OLD_TIME_SPACING)
+constexpr TimeSpacingKind TIME_SPACING_KIND = OLD_TIME_SPACING;
+#else
+constexpr TimeSpacingKind TIME_SPACING_KIND = NO_TIME_SPACING;
+#endif
+
+template<class T>
+static inline void write_values(std::ofstream& file, const T* values, const size_t size)
+{
+    static_assert(std::is_trivially_copyable<T>::value);
+    file.write(reinterpret_cast<const char*>(values), sizeof(T) * size);
+}
+
+template<class T>
+static inline void write_value(std::ofstream& file, const T value)
+{
+    write_values(file, &value, 1);
+}
+
+template<class T>
+static inline void read_values(std::ifstream& file, T* values, const size_t size)
+{
+    static_assert(std::is_trivially_copyable<T>::value);
+    file.read(reinterpret_cast<char*>(values), sizeof(T) * size);
+    release_assert(file.good(), "Checkpoint is truncated");
+}
+
+template<class T>
+static inline T read_value(std::ifstream& file)
+{
+    T value;
+    read_values(file, &value, 1);
+    return value;
+}
+
+// Hash the passable cells of a map with FNV-1a
+static uint64_t hash_map(const Map& map)
+{
+    uint64_t hash = 0xcbf29ce484222325;
+    for (Node n = 0; n < map.size(); ++n)
+    {
+        hash = (hash ^ static_cast<uint64_t>(map[n])) * 0x100000001b3;
+    }
+    return hash;
+}
+
+// Check that a column of a checkpoint is a valid path of its agent
+static bool is_valid_column(
+    const Map& map,              // Map
+    const AgentsData& agents,    // Agents
+    const Agent a,               // Agent of the column
+    const Vector<Edge>& path     // Path of the column
+)
+{
+    // Check the start and goal.
+    if (path.empty() || path.front().n != agents[a].start || path.back().n != agents[a].goal)
+    {
+        return false;
+    }
+
+    // Check that every position is passable and every move goes to the next position.
+    for (Time t = 0; t < static_cast<Time>(path.size()); ++t)
+    {
+        const auto n = path[t].n;
+        if (n >= map.size() || !map[n])
+        {
+            return false;
+        }
+        if (t < static_cast<Time>(path.size()) - 1)
+        {
+            const auto d = path[t].d;
+            if (d > Direction::WAIT || !map.can_move(n, d) || map.get_destination(n, d) != path[t + 1].n)
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Write the columns, the cuts and the incumbent to a checkpoint
+SCIP_RETCODE write_checkpoint(
+    SCIP* scip,                                      // SCIP
+    const std::filesystem::path& checkpoint_path     // File path to checkpoint
+)
+{
+    // Check.
+    if (SCIPgetStage(scip) < SCIP_STAGE_TRANSFORMED || SCIPgetStage(scip) > SCIP_STAGE_SOLVED)
+    {
+        println("Skipping checkpoint because the problem is not transformed");
+        return SCIP_OKAY;
+    }
+
+    // Get problem data.
+    auto probdata = SCIPgetProbData(scip);
+    const auto N = SCIPprobdataGetN(probdata);
+    const auto& map = SCIPprobdataGetMap(probdata);
+    const auto& agents = SCIPprobdataGetAgentsData(probdata);
+    const auto& vars = SCIPprobdataGetVars(probdata);
+
+    // Write to a temporary file and then replace the previous checkpoint so that an interruption while writing
+    // keeps the previous checkpoint intact.
+    auto tmp_path = checkpoint_path;
+    tmp_path += ".tmp";
+    std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+    release_assert(file.good(), "Cannot create checkpoint file {}", tmp_path.string());
+
+    // Write header.
+    write_value<uint32_t>(file, CHECKPOINT_MAGIC);
+    write_value<uint32_t>(file, CHECKPOINT_VERSION);
+    write_value<Agent>(file, N);
+    write_value<Position>(file, map.width());
+    write_value<Position>(file, map.height());
+    write_value<uint64_t>(file, hash_map(map));
+    write_value<Int>(file, SCIPprobdataGetTimeSpacing(probdata));
+    for (Agent a = 0; a < N; ++a)
+    {
+        write_value<Node>(file, agents[a].start);
+        write_value<Node>(file, agents[a].goal);
+    }
+
+    // Write columns.
+    HashTable<SCIP_VAR*, uint64_t> column_idx;
+    write_value<uint64_t>(file, vars.size());
+    for (uint64_t idx = 0; idx < vars.size(); ++idx)
+    {
+        const auto var = vars[idx].first;
+        auto vardata = SCIPvarGetData(var);
+        const auto path_length = SCIPvardataGetPathLength(vardata);
+        const auto path = SCIPvardataGetPath(vardata);
+        column_idx[var] = idx;
+        write_value<Agent>(file, SCIPvardataGetAgent(vardata));
+        write_value<Time>(file, path_length);
+        write_values(file, path, path_length);
+    }
+
+    // Write the index of the column of every agent in the incumbent.
+    {
+        Vector<uint64_t> incumbent(N, std::numeric_limits<uint64_t>::max());
+        bool found = false;
+        if (auto sol = SCIPgetBestSol(scip); sol)
+        {
+            found = true;
+            for (const auto& [var, idx] : column_idx)
+                if (SCIPisPositive(scip, SCIPgetSolVal(scip, sol, var)))
+                {
+                    incumbent[SCIPvardataGetAgent(SCIPvarGetData(var))] = idx;
+                }
+            for (Agent a = 0; a < N; ++a)
+            {
+                found &= incumbent[a] != std::numeric_limits<uint64_t>::max();
+            }
+        }
+        write_value<uint8_t>(file, found);
+        if (found)
+        {
+            write_values(file, incumbent.data(), N);
+        }
+    }
+
+    // Write vertex conflicts.
+    size_t nb_cuts = 0;
+    {
+        const auto& vertex_conflicts = vertex_conflicts_get_constraints(probdata);
+        write_value<uint64_t>(file, vertex_conflicts.size());
+        for (const auto& [nt, _] : vertex_conflicts)
+        {
+            write_value<uint64_t>(file, nt.nt);
+        }
+        nb_cuts += vertex_conflicts.size();
+    }
+
+    // Write edge conflicts.
+    {
+        const auto& edge_conflicts = edge_conflicts_get_constraints(probdata);
+        write_value<Int>(file, std::tuple_size<decltype(EdgeConflict::edges)>::value);
+        write_value<uint64_t>(file, edge_conflicts.size());
+        for (const auto& [_, conflict] : edge_conflicts)
+        {
+            write_value<Time>(file, conflict.t);
+            write_values(file, conflict.edges.data(), conflict.edges.size());
+        }
+        nb_cuts += edge_conflicts.size();
+    }
+
+    // Write time spacing conflicts.
+    write_value<uint8_t>(file, TIME_SPACING_KIND);
+    {
+#if defined(USE_NEW_TIME_SPACING)
+        const auto& time_spacing_conflicts = new_time_spacing_get_constraints(probdata);
+        write_value<uint64_t>(file, time_spacing_conflicts.size());
+        for (const auto& [ntah, _] : time_spacing_conflicts)
+        {
+            write_value<uint64_t>(file, ntah.ntah);
+        }
+        nb_cuts += time_spacing_conflicts.size();
+#elif defined(USE_OLD_TIME_SPACING)
+        const auto& time_spacing_conflicts = old_time_spacing_get_constraints(probdata);
+        write_value<uint64_t>(file, time_spacing_conflicts.size());
+        for (const auto& [nta, _] : time_spacing_conflicts)
+        {
+            write_value<uint64_t>(file, nta.nta);
+        }
+        nb_cuts += time_spacing_conflicts.size();
+#else
+        write_value<uint64_t>(file, 0);
+#endif
+    }
+
+    // Write two-agent robust cuts.
+    {
+        const auto& two_agent_robust_cuts = SCIPprobdataGetTwoAgentRobustCuts(probdata);
+        write_value<uint64_t>(file, two_agent_robust_cuts.size());
+        for (const auto& cut : two_agent_robust_cuts)
+        {
+            const String sepa = SCIPsepaGetName(SCIProwGetOriginSepa(cut.row()));
+            write_value<uint64_t>(file, sepa.size());
+            write_values(file, sepa.data(), sepa.size());
+            write_value<SCIP_Real>(file, SCIProwGetRhs(cut.row()));
+            write_value<Agent>(file, cut.a1());
+            write_value<Agent>(file, cut.a2());
+            write_value<Int>(file, cut.a1_edge_times_end() - cut.a1_edge_times_begin());
+            write_value<Int>(file, cut.size());
+            write_values(file, cut.begin(), cut.size());
+        }
+        nb_cuts += two_agent_robust_cuts.size();
+    }
+
+    // Replace the previous checkpoint.
+    file.close();
+    release_assert(!file.fail(), "Failed to write checkpoint file {}", tmp_path.string());
+    std::filesystem::rename(tmp_path, checkpoint_path);
+
+    // Print.
+    println("Saved {} columns and {} cuts to checkpoint {}", vars.size(), nb_cuts, checkpoint_path.string());
+
+    // Done.
+    return SCIP_OKAY;
+}
+
+// Read a checkpoint, add its columns, submit its incumbent and store its cuts for the first separation round
+SCIP_RETCODE read_checkpoint(
+    SCIP* scip,                                      // SCIP
+    const std::filesystem::path& checkpoint_path     // File path to checkpoint
+)
+{
+    // Get problem data.
+    auto probdata = SCIPgetProbData(scip);
+    const auto N = SCIPprobdataGetN(probdata);
+    const auto& map = SCIPprobdataGetMap(probdata);
+    const auto& agents = SCIPprobdataGetAgentsData(probdata);
+    auto& cuts = SCIPprobdataGetCheckpointCuts(probdata);
+
+    // Open file.
+    std::ifstream file(checkpoint_path, std::ios::binary);
+    release_assert(file.good(), "Cannot find checkpoint file {}", checkpoint_path.string());
+
+    // Check that the checkpoint belongs to the same problem.
+    release_assert(read_value<uint32_t>(file) == CHECKPOINT_MAGIC,
+                   "File {} is not a checkpoint", checkpoint_path.string());
+    release_assert(read_value<uint32_t>(file) == CHECKPOINT_VERSION,
+                   "Checkpoint {} is written by a different version", checkpoint_path.string());
+    release_assert(read_value<Agent>(file) == N &&
+                   read_value<Position>(file) == map.width() &&
+                   read_value<Position>(file) == map.height() &&
+                   read_value<uint64_t>(file) == hash_map(map) &&
+                   read_value<Int>(file) == SCIPprobdataGetTimeSpacing(probdata),
+                   "Checkpoint {} belongs to a different instance", checkpoint_path.string());
+    for (Agent a = 0; a < N; ++a)
+    {
+        const auto start = read_value<Node>(file);
+        const auto goal = read_value<Node>(file);
+        release_assert(start == agents[a].start && goal == agents[a].goal,
+                       "Checkpoint {} has a different start or goal for agent {}", checkpoint_path.string(), a);
+    }
+
+    // Read columns.
+    Vector<SCIP_VAR*> vars(read_value<uint64_t>(file));
+    {
+        Vector<Edge> path;
+        for (auto& var : vars)
+        {
+            const auto a = read_value<Agent>(file);
+            const auto path_length = read_value<Time>(file);
+            release_assert(0 <= a && a < N && path_length > 0, "Checkpoint has an invalid column");
+            path.resize(path_length);
+            read_values(file, path.data(), path.size());
+            release_assert(is_valid_column(map, agents, a, path), "Checkpoint has an invalid path for agent {}", a);
+
+            SCIP_CALL(SCIPprobdataAddInitialVar(scip, probdata, a, path.size(), path.data(), &var));
+            debug_assert(var);
+        }
+    }
+
+    // Read incumbent.
+    Vector<uint64_t> incumbent;
+    if (read_value<uint8_t>(file))
+    {
+        incumbent.resize(N);
+        read_values(file, incumbent.data(), N);
+    }
+
+    // Read vertex conflicts.
+    cuts.vertex_conflicts.resize(read_value<uint64_t>(file));
+    for (auto& nt : cuts.vertex_conflicts)
+    {
+        nt.nt = read_value<uint64_t>(file);
+    }
+
+    // Read edge conflicts.
+    {
+        const auto nb_edges = read_value<Int>(file);
+        cuts.edge_conflicts.resize(read_value<uint64_t>(file));
+        for (auto& [t, edges] : cuts.edge_conflicts)
+        {
+            t = read_value<Time>(file);
+            edges.resize(nb_edges);
+            read_values(file, edges.data(), nb_edges);
+        }
+        if (nb_edges != static_cast<Int>(std::tuple_size<decltype(EdgeConflict::edges)>::value))
+        {
+            println("Skipping edge conflicts of checkpoint because of a different edge conflict formulation");
+            cuts.edge_conflicts.clear();
+        }
+    }
+
+    // Read time spacing conflicts.
+    {
+        const auto kind = read_value<uint8_t>(file);
+        cuts.time_spacing_conflicts.resize(read_value<uint64_t>(file));
+        read_values(file, cuts.time_spacing_conflicts.data(), cuts.time_spacing_conflicts.size());
+        if (kind != TIME_SPACING_KIND)
+        {
+            println("Skipping time spacing conflicts of checkpoint because of a different time spacing formulation");
+            cuts.time_spacing_conflicts.clear();
+        }
+    }
+
+    // Read two-agent robust cuts.
+    cuts.two_agent_robust_cuts.resize(read_value<uint64_t>(file));
+    for (auto& cut : cuts.two_agent_robust_cuts)
+    {
+        cut.sepa.resize(read_value<uint64_t>(file));
+        read_values(file, cut.sepa.data(), cut.sepa.size());
+        cut.rhs = read_value<SCIP_Real>(file);
+        cut.a1 = read_value<Agent>(file);
+        cut.a2 = read_value<Agent>(file);
+        cut.nb_a1_edge_times = read_value<Int>(file);
+        cut.edge_times.resize(read_value<Int>(file));
+        read_values(file, cut.edge_times.data(), cut.edge_times.size());
+    }
+    const auto nb_cuts = cuts.vertex_conflicts.size() +
+                         cuts.edge_conflicts.size() +
+                         cuts.time_spacing_conflicts.size() +
+                         cuts.two_agent_robust_cuts.size();
+    println("Resuming from checkpoint {} with {} columns and {} cuts",
+            checkpoint_path.string(), vars.size(), nb_cuts);
+
+    // Submit the incumbent.
+    if (!incumbent.empty())
+    {
+        SCIP_SOL* sol = nullptr;
+        SCIP_CALL(SCIPcreateSol(scip, &sol, nullptr));
+        for (Agent a = 0; a < N; ++a)
+        {
+            const auto idx = incumbent[a];
+            release_assert(idx < vars.size() && SCIPvardataGetAgent(SCIPvarGetData(vars[idx])) == a,
+                           "Checkpoint has an invalid incumbent");
+            SCIP_CALL(SCIPsetSolVal(scip, sol, vars[idx], 1.0));
+        }
+        const auto obj = SCIPgetSolOrigObj(scip, sol);
+        SCIP_Bool success;
+        SCIP_CALL(SCIPtrySol(scip, sol, TRUE, TRUE, FALSE, TRUE, TRUE, &success));
+        SCIP_CALL(SCIPfreeSol(scip, &sol));
+        println("Incumbent of checkpoint with cost {:.0f} is {}", obj, success ? "accepted" : "infeasible");
+    }
+
+    // Done.
+    return SCIP_OKAY;
+}
+
+// Add the cuts of a checkpoint to the LP
+SCIP_RETCODE add_checkpoint_cuts(
+    SCIP* scip,            // SCIP
+    SCIP_RESULT* result    // Output result
+)
+{
+    // Get problem data.
+    auto probdata = SCIPgetProbData(scip);
+    auto& cuts = SCIPprobdataGetCheckpointCuts(probdata);
+    if (cuts.empty())
+    {
+        return SCIP_OKAY;
+    }
+
+    // Add the cuts. The outcome is cutoff if any cut is infeasible.
+    Int nb_added = 0;
+    auto update_result = [&](const SCIP_RESULT cut_result)
+    {
+        nb_added++;
+        if (cut_result == SCIP_CUTOFF || *result == SCIP_CUTOFF)
+        {
+            *result = SCIP_CUTOFF;
+        }
+        else if (cut_result == SCIP_SEPARATED)
+        {
+            *result = SCIP_SEPARATED;
+        }
+    };
+    for (const auto nt : cuts.vertex_conflicts)
+    {
+        SCIP_RESULT cut_result = SCIP_DIDNOTFIND;
+        SCIP_CALL(vertex_conflicts_add_checkpoint_cut(scip, nt, &cut_result));
+        update_result(cut_result);
+    }
+    for (const auto& [t, edges] : cuts.edge_conflicts)
+    {
+        decltype(EdgeConflict::edges) conflict_edges;
+        std::copy(edges.begin(), edges.end(), conflict_edges.begin());
+
+        SCIP_RESULT cut_result = SCIP_DIDNOTFIND;
+        SCIP_CALL(edge_conflicts_add_checkpoint_cut(scip, t, conflict_edges, &cut_result));
+        update_result(cut_result);
+    }
+#if defined(USE_NEW_TIME_SPACING) || defined(USE_OLD_TIME_SPACING)
+    for (const auto key : cuts.time_spacing_conflicts)
+    {
+        SCIP_RESULT cut_result = SCIP_DIDNOTFIND;
+#ifdef USE_NEW_TIME_SPACING
+        SCIP_CALL(new_time_spacing_add_checkpoint_cut(scip, NodeTimeAgentSpace{key}, &cut_result));
+#else
+        SCIP_CALL(old_time_spacing_add_checkpoint_cut(scip, NodeTimeAgent{key}, &cut_result));
+#endif
+        update_result(cut_result);
+    }
+#endif
+    for (const auto& checkpoint_cut : cuts.two_agent_robust_cuts)
+    {
+        // Skip the cut if its separator is not included.
+        auto sepa = SCIPfindSepa(scip, checkpoint_cut.sepa.c_str());
+        if (!sepa)
+        {
+            continue;
+        }
+
+        // Create the cut.
+        const auto nb_a1_edge_times = checkpoint_cut.nb_a1_edge_times;
+        const auto nb_a2_edge_times = static_cast<Int>(checkpoint_cut.edge_times.size()) - nb_a1_edge_times;
+        TwoAgentRobustCut cut(scip, checkpoint_cut.a1, checkpoint_cut.a2, nb_a1_edge_times, nb_a2_edge_times
+#ifdef DEBUG
+            , fmt::format("{}_checkpoint({},{})", checkpoint_cut.sepa, checkpoint_cut.a1, checkpoint_cut.a2)
+#endif
+        );
+        for (Int idx = 0; idx < nb_a1_edge_times; ++idx)
+        {
+            cut.a1_edge_time(idx) = checkpoint_cut.edge_times[idx];
+        }
+        for (Int idx = 0; idx < nb_a2_edge_times; ++idx)
+        {
+            cut.a2_edge_time(idx) = checkpoint_cut.edge_times[nb_a1_edge_times + idx];
+        }
+
+        // Store the cut.
+        SCIP_RESULT cut_result = SCIP_DIDNOTFIND;
+        SCIP_CALL(SCIPprobdataAddTwoAgentRobustCut(scip,
+                                                   probdata,
+                                                   sepa,
+                                                   std::move(cut),
+                                                   checkpoint_cut.rhs,
+                                                   &cut_result,
+                                                   nullptr,
+                                                   false));
+        update_result(cut_result);
+    }
+
+    // Print.
+    println("Added {} cuts of checkpoint", nb_added);
+
+    // Clear the cuts so that they are only added once.
+    cuts = CheckpointCuts();
+
+    // Done.
+    return SCIP_OKAY;
+}
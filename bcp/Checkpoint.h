@@ -0,0 +1,74 @@
+/*
+This file is part of BCP-MAPF.
+
+BCP-MAPF is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+BCP-MAPF is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+Author: Edward Lam <ed@ed-lam.com>
+*/
+
+
+#ifndef MAPF_CHECKPOINT_H
+#define MAPF_CHECKPOINT_H
+
+#include "Includes.h"
+#include "Coordinates.h"
+#include <filesystem>
+
+// Two-agent robust cut read from a checkpoint
+struct CheckpointRobustCut
+{
+    String sepa;                    // Name of the separator that created the cut
+    SCIP_Real rhs;                  // RHS
+    Agent a1;                       // Agent 1
+    Agent a2;                       // Agent 2
+    Int nb_a1_edge_times;           // Number of edge-times of agent 1
+    Vector<EdgeTime> edge_times;    // Edge-times of agent 1 followed by those of agent 2
+};
+
+// Cuts read from a checkpoint and waiting to be added to the LP
+struct CheckpointCuts
+{
+    Vector<NodeTime> vertex_conflicts;                    // Node-times of vertex conflicts
+    Vector<Pair<Time, Vector<Edge>>> edge_conflicts;      // Times and edges of edge conflicts
+    Vector<uint64_t> time_spacing_conflicts;              // Keys of time spacing conflicts
+    Vector<CheckpointRobustCut> two_agent_robust_cuts;    // Two-agent robust cuts
+
+    inline bool empty() const
+    {
+        return vertex_conflicts.empty() &&
+               edge_conflicts.empty() &&
+               time_spacing_conflicts.empty() &&
+               two_agent_robust_cuts.empty();
+    }
+};
+
+// Write the columns, the cuts and the incumbent to a checkpoint
+SCIP_RETCODE write_checkpoint(
+    SCIP* scip,                                      // SCIP
+    const std::filesystem::path& checkpoint_path     // File path to checkpoint
+);
+
+// Read a checkpoint, add its columns, submit its incumbent and store its cuts for the first separation round
+SCIP_RETCODE read_checkpoint(
+    SCIP* scip,                                      // SCIP
+    const std::filesystem::path& checkpoint_path     // File path to checkpoint
+);
+
+// Add the cuts of a checkpoint to the LP
+SCIP_RETCODE add_checkpoint_cuts(
+    SCIP* scip,            // SCIP
+    SCIP_RESULT* result    // Output result
+);
+
+#endif
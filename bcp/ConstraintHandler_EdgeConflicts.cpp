@@ -105,9 +105,13 @@ SCIP_RETCODE edge_conflicts_create_cut(
     const Array<Edge, 2> edges,                        // Edges in the conflict
 #endif
     const Vector<Pair<SCIP_VAR*, SCIP_Real>>& vars,    // Variables
-    SCIP_Result* result                                // Output result
+    SCIP_Result* result,                               // Output result
+    [[maybe_unused]] const bool violated = true        // Is the cut violated by the current solution?
 )
 {
+    // Trace.
+    TRACE_SCOPE("create_row");
+
     // Get problem data.
 #ifdef USE_WAITEDGE_CONFLICTS
     auto probdata = SCIPgetProbData(scip);
@@ -177,7 +181,7 @@ SCIP_RETCODE edge_conflicts_create_cut(
     }
     SCIP_CALL(SCIPflushRowExtensions(scip, row));
 #ifdef DEBUG
-    debug_assert(SCIPisSumGT(scip, lhs, 1.0 - 1e-6));
+    debug_assert(!violated || SCIPisSumGT(scip, lhs, 1.0 - 1e-6));
 #endif
 
     // Add the row to the LP.
@@ -299,6 +303,9 @@ SCIP_RETCODE edge_conflicts_separate(
     SCIP_RESULT* result         // Pointer to store the result
 )
 {
+    // Trace.
+    TRACE_SCOPE(CONSHDLR_NAME);
+
     // Print.
     debugln("Starting separator for edge conflicts on solution with obj {:.6f}:",
             SCIPgetSolOrigObj(scip, sol));
@@ -926,3 +933,32 @@ const HashTable<EdgeTime, EdgeConflict>& edge_conflicts_get_constraints(
     debug_assert(consdata);
     return consdata->conflicts;
 }
+
+SCIP_RETCODE edge_conflicts_add_checkpoint_cut(
+    SCIP* scip,                        // SCIP
+    const Time t,                      // Time
+#ifdef USE_WAITEDGE_CONFLICTS
+    const Array<Edge, 3> edges,        // Edges in the conflict
+#else
+    const Array<Edge, 2> edges,        // Edges in the conflict
+#endif
+    SCIP_Result* result                // Output result
+)
+{
+    // Get constraint data.
+    auto probdata = SCIPgetProbData(scip);
+    auto cons = SCIPprobdataGetEdgeConflictsCons(probdata);
+    debug_assert(cons);
+    auto consdata = reinterpret_cast<EdgeConflictsConsData*>(SCIPconsGetData(cons));
+    debug_assert(consdata);
+
+    // Create the cut if it does not already exist.
+    if (consdata->conflicts.find(EdgeTime{edges[0], t}) == consdata->conflicts.end())
+    {
+        const auto& vars = SCIPprobdataGetVars(probdata);
+        SCIP_CALL(edge_conflicts_create_cut(scip, cons, consdata, t, edges, vars, result, false));
+    }
+
+    // Done.
+    return SCIP_OKAY;
+}
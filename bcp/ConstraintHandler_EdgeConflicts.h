@@ -70,4 +70,16 @@ const HashTable<EdgeTime, EdgeConflict>& edge_conflicts_get_constraints(
     SCIP_ProbData* probdata    // Problem data
 );
 
+// Add an edge conflict stored in a checkpoint
+SCIP_RETCODE edge_conflicts_add_checkpoint_cut(
+    SCIP* scip,                    // SCIP
+    const Time t,                  // Time
+#ifdef USE_WAITEDGE_CONFLICTS
+    const Array<Edge, 3> edges,    // Edges in the conflict
+#else
+    const Array<Edge, 2> edges,    // Edges in the conflict
+#endif
+    SCIP_Result* result            // Output result
+);
+
 #endif
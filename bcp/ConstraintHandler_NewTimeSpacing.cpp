@@ -79,9 +79,13 @@ SCIP_RETCODE new_time_spacing_create_cut(
     NewTimeSpacingConsData* consdata,                  // Constraint data
     const NodeTimeAgentSpace ntah,                     // Node-time of the conflict
     const Vector<Pair<SCIP_VAR*, SCIP_Real>>& vars,    // Variables
-    SCIP_Result* result                                // Output result
+    SCIP_Result* result,                               // Output result
+    [[maybe_unused]] const bool violated = true        // Is the cut violated by the current solution?
 )
 {
+    // Trace.
+    TRACE_SCOPE("create_row");
+
     // Get problem data.
     auto probdata = SCIPgetProbData(scip);
     const auto N = SCIPprobdataGetN(probdata);
@@ -144,7 +148,7 @@ SCIP_RETCODE new_time_spacing_create_cut(
     }
     SCIP_CALL(SCIPflushRowExtensions(scip, row));
 #ifdef DEBUG
-    debug_assert(SCIPisSumGT(scip, lhs, 1.0 - 1e-6));
+    debug_assert(!violated || SCIPisSumGT(scip, lhs, 1.0 - 1e-6));
 #endif
 
     // Add the row to the LP.
@@ -246,6 +250,9 @@ SCIP_RETCODE new_time_spacing_separate(
     SCIP_RESULT* result         // Pointer to store the result
 )
 {
+    // Trace.
+    TRACE_SCOPE(CONSHDLR_NAME);
+
     // Print.
     debugln("Starting separator for new time spacing on solution with obj {:.6f}:",
             SCIPgetSolOrigObj(scip, nullptr));
@@ -788,4 +795,28 @@ const HashTable<NodeTimeAgentSpace, NewTimeSpacing>& new_time_spacing_get_constr
     return consdata->conflicts;
 }
 
-#endif
\ No newline at end of file
+SCIP_RETCODE new_time_spacing_add_checkpoint_cut(
+    SCIP* scip,                       // SCIP
+    const NodeTimeAgentSpace ntah,    // Node-time, agent and spacing of the conflict
+    SCIP_Result* result               // Output result
+)
+{
+    // Get constraint data.
+    auto probdata = SCIPgetProbData(scip);
+    auto cons = SCIPprobdataGetNewTimeSpacingCons(probdata);
+    debug_assert(cons);
+    auto consdata = reinterpret_cast<NewTimeSpacingConsData*>(SCIPconsGetData(cons));
+    debug_assert(consdata);
+
+    // Create the cut if it does not already exist.
+    if (consdata->conflicts.find(ntah) == consdata->conflicts.end())
+    {
+        const auto& vars = SCIPprobdataGetVars(probdata);
+        SCIP_CALL(new_time_spacing_create_cut(scip, cons, consdata, ntah, vars, result, false));
+    }
+
+    // Done.
+    return SCIP_OKAY;
+}
+
+#endif
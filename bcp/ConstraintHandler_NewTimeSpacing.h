@@ -90,6 +90,13 @@ const HashTable<NodeTimeAgentSpace, NewTimeSpacing>& new_time_spacing_get_constr
     SCIP_ProbData* probdata    // Problem data
 );
 
+// Add a time spacing conflict stored in a checkpoint
+SCIP_RETCODE new_time_spacing_add_checkpoint_cut(
+    SCIP* scip,                       // SCIP
+    const NodeTimeAgentSpace ntah,    // Node-time, agent and spacing of the conflict
+    SCIP_Result* result               // Output result
+);
+
 #endif
 
 #endif
\ No newline at end of file
@@ -79,9 +79,13 @@ SCIP_RETCODE old_time_spacing_create_cut(
     OldTimeSpacingConsData* consdata,                 // Constraint data
     const NodeTimeAgent nta,                                 // Node-time of the conflict
     const Vector<Pair<SCIP_VAR*, SCIP_Real>>& vars,    // Variables
-    SCIP_Result* result                                // Output result
+    SCIP_Result* result,                               // Output result
+    const bool violated = true                         // Is the cut violated by the current solution?
 )
 {
+    // Trace.
+    TRACE_SCOPE("create_row");
+
     // Get problem data.
     auto probdata = SCIPgetProbData(scip);
     const auto N = SCIPprobdataGetN(probdata);
@@ -147,7 +151,7 @@ SCIP_RETCODE old_time_spacing_create_cut(
     }
     SCIP_CALL(SCIPflushRowExtensions(scip, row));
 #ifdef DEBUG
-    debug_assert(SCIPisSumGT(scip, lhs, 1.0 - 1e-6));
+    debug_assert(!violated || SCIPisSumGT(scip, lhs, 1.0 - 1e-6));
 #endif
 
     // Add the row to the LP.
@@ -251,6 +255,9 @@ SCIP_RETCODE old_time_spacing_separate(
     SCIP_RESULT* result         // Pointer to store the result
 )
 {
+    // Trace.
+    TRACE_SCOPE(CONSHDLR_NAME);
+
     // Print.
     debugln("Starting separator for old time spacing on solution with obj {:.6f}:",
             SCIPgetSolOrigObj(scip, nullptr));
@@ -811,4 +818,28 @@ const HashTable<NodeTimeAgent, OldTimeSpacing>& old_time_spacing_get_constraints
     return consdata->conflicts;
 }
 
-#endif
\ No newline at end of file
+SCIP_RETCODE old_time_spacing_add_checkpoint_cut(
+    SCIP* scip,                 // SCIP
+    const NodeTimeAgent nta,    // Node-time and agent of the conflict
+    SCIP_Result* result         // Output result
+)
+{
+    // Get constraint data.
+    auto probdata = SCIPgetProbData(scip);
+    auto cons = SCIPprobdataGetOldTimeSpacingCons(probdata);
+    debug_assert(cons);
+    auto consdata = reinterpret_cast<OldTimeSpacingConsData*>(SCIPconsGetData(cons));
+    debug_assert(consdata);
+
+    // Create the cut if it does not already exist.
+    if (consdata->conflicts.find(nta) == consdata->conflicts.end())
+    {
+        const auto& vars = SCIPprobdataGetVars(probdata);
+        SCIP_CALL(old_time_spacing_create_cut(scip, cons, consdata, nta, vars, result, false));
+    }
+
+    // Done.
+    return SCIP_OKAY;
+}
+
+#endif
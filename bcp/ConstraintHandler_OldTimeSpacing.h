@@ -102,6 +102,13 @@ const HashTable<NodeTimeAgent, OldTimeSpacing>& old_time_spacing_get_constraints
     SCIP_ProbData* probdata    // Problem data
 );
 
+// Add a time spacing conflict stored in a checkpoint
+SCIP_RETCODE old_time_spacing_add_checkpoint_cut(
+    SCIP* scip,                 // SCIP
+    const NodeTimeAgent nta,    // Node-time and agent of the conflict
+    SCIP_Result* result         // Output result
+);
+
 #endif
 
 #endif
@@ -96,9 +96,13 @@ SCIP_RETCODE vertex_conflicts_create_cut(
     VertexConflictsConsData* consdata,                 // Constraint data
     const NodeTime nt,                                 // Node-time of the conflict
     const Vector<Pair<SCIP_VAR*, SCIP_Real>>& vars,    // Variables
-    SCIP_Result* result                                // Output result
+    SCIP_Result* result,                               // Output result
+    [[maybe_unused]] const bool violated = true        // Is the cut violated by the current solution?
 )
 {
+    // Trace.
+    TRACE_SCOPE("create_row");
+
     // Get problem data.
     auto probdata = SCIPgetProbData(scip);
     const auto N = SCIPprobdataGetN(probdata);
@@ -160,7 +164,7 @@ SCIP_RETCODE vertex_conflicts_create_cut(
     }
     SCIP_CALL(SCIPflushRowExtensions(scip, row));
 #ifdef DEBUG
-    debug_assert(SCIPisSumGT(scip, lhs, 1.0 - 1e-6));
+    debug_assert(!violated || SCIPisSumGT(scip, lhs, 1.0 - 1e-6));
 #endif
 
     // Add the row to the LP.
@@ -296,6 +300,9 @@ SCIP_RETCODE vertex_conflicts_separate(
     SCIP_RESULT* result         // Pointer to store the result
 )
 {
+    // Trace.
+    TRACE_SCOPE(CONSHDLR_NAME);
+
     // Print.
     debugln("Starting separator for vertex conflicts on solution with obj {:.6f}:",
             SCIPgetSolOrigObj(scip, nullptr));
@@ -843,3 +850,27 @@ const HashTable<NodeTime, VertexConflict>& vertex_conflicts_get_constraints(
     debug_assert(consdata);
     return consdata->conflicts;
 }
+
+SCIP_RETCODE vertex_conflicts_add_checkpoint_cut(
+    SCIP* scip,               // SCIP
+    const NodeTime nt,        // Node-time of the conflict
+    SCIP_Result* result       // Output result
+)
+{
+    // Get constraint data.
+    auto probdata = SCIPgetProbData(scip);
+    auto cons = SCIPprobdataGetVertexConflictsCons(probdata);
+    debug_assert(cons);
+    auto consdata = reinterpret_cast<VertexConflictsConsData*>(SCIPconsGetData(cons));
+    debug_assert(consdata);
+
+    // Create the cut if it does not already exist.
+    if (consdata->conflicts.find(nt) == consdata->conflicts.end())
+    {
+        const auto& vars = SCIPprobdataGetVars(probdata);
+        SCIP_CALL(vertex_conflicts_create_cut(scip, cons, consdata, nt, vars, result, false));
+    }
+
+    // Done.
+    return SCIP_OKAY;
+}
@@ -64,4 +64,11 @@ const HashTable<NodeTime, VertexConflict>& vertex_conflicts_get_constraints(
     SCIP_ProbData* probdata    // Problem data
 );
 
+// Add a vertex conflict stored in a checkpoint
+SCIP_RETCODE vertex_conflicts_add_checkpoint_cut(
+    SCIP* scip,             // SCIP
+    const NodeTime nt,      // Node-time of the conflict
+    SCIP_Result* result     // Output result
+);
+
 #endif
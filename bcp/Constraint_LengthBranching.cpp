@@ -45,6 +45,8 @@ struct LengthBranchingConsData
     Int npropagatedvars;          // Number of variables that existed when the related node
                                   // was propagated the last time. Used to determine whether
                                   // the constraint should be repropagated
+    Int npurges;                  // Number of purges of the variables when the related node
+                                  // was propagated the last time
     bool propagated : 1;          // Is the constraint already propagated?
     SCIP_NODE* node;              // The node of the branch-and-bound tree for this constraint
 };
@@ -72,6 +74,7 @@ SCIP_RETCODE consdataCreate(
     (*consdata)->a = a;
     (*consdata)->nt = nt;
     (*consdata)->npropagatedvars = 0;
+    (*consdata)->npurges = 0;
     (*consdata)->propagated = false;
     (*consdata)->node = node;
 
@@ -79,6 +82,22 @@ SCIP_RETCODE consdataCreate(
     return SCIP_OKAY;
 }
 
+// Check all variables again if variables were purged since the last propagation
+static inline
+void check_purges(
+    SCIP_ProbData* probdata,             // Problem data
+    LengthBranchingConsData* consdata    // Constraint data
+)
+{
+    const auto npurges = SCIPprobdataGetNPurges(probdata);
+    if (consdata->npurges != npurges)
+    {
+        consdata->npropagatedvars = 0;
+        consdata->npurges = npurges;
+        consdata->propagated = FALSE;
+    }
+}
+
 // Fix a variable to zero if its path is not valid for this constraint/branch
 static inline
 SCIP_RETCODE check_variable(
@@ -357,6 +376,7 @@ SCIP_DECL_CONSPROP(consPropLengthBranching)
         debug_assert(consdata);
 
         // Check if all variables are valid for this constraint.
+        check_purges(probdata, consdata);
 #ifdef DEBUG
         check_propagation(probdata, consdata, TRUE);
 #endif
@@ -431,6 +451,7 @@ SCIP_DECL_CONSACTIVE(consActiveLengthBranching)
     // Get constraint data.
     auto consdata = reinterpret_cast<LengthBranchingConsData*>(SCIPconsGetData(cons));
     debug_assert(consdata);
+    check_purges(probdata, consdata);
     debug_assert(consdata->npropagatedvars <= nvars);
 
     // Print.
@@ -501,6 +522,7 @@ SCIP_DECL_CONSDEACTIVE(consDeactiveLengthBranching)
 #ifndef USE_LNS2_REPAIR_PRIMAL_HEURISTIC
     const auto& vars = SCIPprobdataGetVars(probdata);
     consdata->npropagatedvars = vars.size();
+    consdata->npurges = SCIPprobdataGetNPurges(probdata);
 #endif
 
     // Done.
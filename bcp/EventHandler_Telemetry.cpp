@@ -0,0 +1,490 @@
+/*
+This file is part of BCP-MAPF.
+
+BCP-MAPF is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+BCP-MAPF is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+Author: Edward Lam <ed@ed-lam.com>
+*/
+
+
+#include "EventHandler_Telemetry.h"
+#include "ProblemData.h"
+#include "Output.h"
+#include "Clock.h"
+#include "Memory.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#define EVENTHDLR_NAME "telemetry"
+#define EVENTHDLR_DESC "Telemetry of the progress of the solver"
+#define EVENTHDLR_TYPE (SCIP_EVENTTYPE_LPSOLVED | SCIP_EVENTTYPE_NODESOLVED)
+
+#define SOCKET_PREFIX "unix:"
+
+// Progress of the solver at one time
+struct TelemetrySnapshot
+{
+    SCIP_Real time;                            // Solving time
+    SCIP_Real primal_bound;                    // Cost of the best solution
+    SCIP_Real dual_bound;                      // Lower bound
+    SCIP_Longint nb_nodes;                     // Number of branch-and-bound nodes solved
+    SCIP_Longint nb_open_nodes;                // Number of branch-and-bound nodes left
+    Int nb_pricing_rounds;                     // Number of pricing rounds
+    SCIP_Real pricing_rounds_per_second;       // Pricing rounds per second since the previous snapshot
+    size_t nb_columns;                         // Number of columns in the master problem
+    SCIP_Longint nb_cuts;                      // Number of cuts found
+    SCIP_Longint scip_memory;                  // Bytes of memory used by SCIP
+    Int label_pool_blocks;                     // Number of blocks of the label pool of the pricer
+    size_t label_pool_peak_bytes;              // Maximum number of bytes of the label pool
+    size_t nb_fractional_vertices;             // Number of entries of the fractional vertices of all agents
+    size_t nb_fractional_edges;                // Number of entries of the fractional edges of all agents
+    size_t nb_robust_cuts;                     // Number of two-agent robust cuts
+    MemoryUsage memory;                        // Bytes of memory used by each part of the solver
+};
+
+// Client of the socket
+struct TelemetryClient
+{
+    int fd;                                    // Socket
+    String pending;                            // End of a line that the socket could not take
+};
+
+// Event handler data
+struct SCIP_EventhdlrData
+{
+    String path;                               // Path to file or socket
+    String instance_file;                      // Path to instance file
+    SCIP_Real interval;                        // Seconds between messages
+    int filterpos;                             // Position of the event filter
+
+    // Data of the solving thread
+    SCIP_Real next_time;                       // Solving time of the next snapshot
+    SCIP_Real prev_time;                       // Solving time of the previous snapshot
+    Int prev_nb_pricing_rounds;                // Number of pricing rounds at the previous snapshot
+
+    // Data shared with the publishing thread
+    std::mutex mutex;                          // Lock on the snapshot and the stop flag
+    std::condition_variable cv;                // Signal of a new snapshot or stopping
+    TelemetrySnapshot snapshot;                // Latest snapshot
+    bool has_snapshot;                         // Indicates if the latest snapshot is not yet published
+    bool stop;                                 // Indicates if the publishing thread should finish
+
+    // Data of the publishing thread
+    std::thread thread;                        // Publishing thread
+    FILE* file;                                // File of messages
+    int listen_fd;                             // Socket accepting clients
+    Vector<TelemetryClient> clients;           // Clients of the socket
+};
+
+// Format a snapshot as a line of JSON
+static
+String format_snapshot(
+    const String& instance_file,          // Path to instance file
+    const TelemetrySnapshot& snapshot     // Progress
+)
+{
+    return fmt::format("{{\"instance\": {}, \"time\": {:.3f}, \"primal_bound\": {}, \"dual_bound\": {}, "
+                       "\"nodes\": {}, \"open_nodes\": {}, \"pricing_rounds\": {}, "
+                       "\"pricing_rounds_per_second\": {:.2f}, \"columns\": {}, \"cuts\": {}, "
+                       "\"scip_memory\": {}, \"label_pool_blocks\": {}, \"label_pool_peak_bytes\": {}, "
+                       "\"fractional_vertices\": {}, \"fractional_edges\": {}, \"robust_cuts\": {}, "
+                       "\"memory\": {{\"label_pools\": {}, \"frontiers\": {}, \"lower_bounds\": {}, \"solution_caches\": {}, "
+                       "\"fractional_values\": {}, \"robust_cuts\": {}, \"columns\": {}, \"total\": {}}}}}\n",
+                       json_string(instance_file),
+                       snapshot.time,
+                       snapshot.primal_bound,
+                       snapshot.dual_bound,
+                       snapshot.nb_nodes,
+                       snapshot.nb_open_nodes,
+                       snapshot.nb_pricing_rounds,
+                       snapshot.pricing_rounds_per_second,
+                       snapshot.nb_columns,
+                       snapshot.nb_cuts,
+                       snapshot.scip_memory,
+                       snapshot.label_pool_blocks,
+                       snapshot.label_pool_peak_bytes,
+                       snapshot.nb_fractional_vertices,
+                       snapshot.nb_fractional_edges,
+                       snapshot.nb_robust_cuts,
+                       snapshot.memory.label_pools,
+                       snapshot.memory.frontiers,
+                       snapshot.memory.heuristic_tables,
+                       snapshot.memory.solution_caches,
+                       snapshot.memory.fractional_values,
+                       snapshot.memory.cuts,
+                       snapshot.memory.columns,
+                       snapshot.memory.total);
+}
+
+// Send as much of the pending bytes as the socket takes without blocking and return false if the client has left
+static
+bool send_pending(
+    const int fd,       // Socket
+    String& pending     // Bytes to send
+)
+{
+    while (!pending.empty())
+    {
+        const auto nb_bytes = send(fd, pending.data(), pending.size(), MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (nb_bytes < 0)
+        {
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        pending.erase(0, nb_bytes);
+    }
+    return true;
+}
+
+// Write a message to the file or to every client of the socket
+static
+void publish_message(
+    SCIP_EventhdlrData* eventhdlrdata,    // Event handler data
+    const String& message                 // Line of JSON
+)
+{
+    // Write to file.
+    if (eventhdlrdata->file)
+    {
+        fputs(message.c_str(), eventhdlrdata->file);
+        fflush(eventhdlrdata->file);
+        return;
+    }
+
+    // Accept new clients.
+    for (int fd; (fd = accept(eventhdlrdata->listen_fd, nullptr, nullptr)) >= 0;)
+    {
+        eventhdlrdata->clients.push_back(TelemetryClient{fd, String()});
+    }
+
+    // Send to the clients. A line that a client cannot take in full is finished before the next line is sent, so
+    // lines are never cut. Skip the message for a client that is not reading fast enough and disconnect a client that
+    // has left.
+    auto& clients = eventhdlrdata->clients;
+    for (auto it = clients.begin(); it != clients.end();)
+    {
+        auto& [fd, pending] = *it;
+        bool connected = send_pending(fd, pending);
+        if (connected && pending.empty())
+        {
+            pending = message;
+            connected = send_pending(fd, pending);
+        }
+        if (!connected)
+        {
+            close(fd);
+            it = clients.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+// Publish the latest snapshot whenever the solving thread stores one
+static
+void publish_loop(
+    SCIP_EventhdlrData* eventhdlrdata    // Event handler data
+)
+{
+    std::unique_lock<std::mutex> lock(eventhdlrdata->mutex);
+    while (true)
+    {
+        eventhdlrdata->cv.wait(lock, [eventhdlrdata]() {
+            return eventhdlrdata->has_snapshot || eventhdlrdata->stop;
+        });
+        if (eventhdlrdata->has_snapshot)
+        {
+            const auto snapshot = eventhdlrdata->snapshot;
+            eventhdlrdata->has_snapshot = false;
+            lock.unlock();
+            publish_message(eventhdlrdata, format_snapshot(eventhdlrdata->instance_file, snapshot));
+            lock.lock();
+        }
+        else if (eventhdlrdata->stop)
+        {
+            break;
+        }
+    }
+}
+
+// Store the progress of the solver and wake the publishing thread
+static
+void take_snapshot(
+    SCIP* scip,                           // SCIP
+    SCIP_EventhdlrData* eventhdlrdata,    // Event handler data
+    const SCIP_Real time                  // Solving time
+)
+{
+    // Get problem data.
+    auto probdata = SCIPgetProbData(scip);
+    debug_assert(probdata);
+
+    // Get the progress.
+    TelemetrySnapshot snapshot{};
+    snapshot.time = time;
+    snapshot.primal_bound = SCIPgetPrimalbound(scip);
+    snapshot.dual_bound = SCIPgetDualbound(scip);
+    snapshot.nb_nodes = SCIPgetNNodes(scip);
+    snapshot.nb_open_nodes = SCIPgetNNodesLeft(scip);
+    {
+        const auto npricers = SCIPgetNActivePricers(scip);
+        auto pricers = SCIPgetPricers(scip);
+        for (Int idx = 0; idx < npricers; ++idx)
+        {
+            snapshot.nb_pricing_rounds += SCIPpricerGetNCalls(pricers[idx]);
+        }
+    }
+    if (time > eventhdlrdata->prev_time)
+    {
+        snapshot.pricing_rounds_per_second = (snapshot.nb_pricing_rounds - eventhdlrdata->prev_nb_pricing_rounds) /
+                                             (time - eventhdlrdata->prev_time);
+    }
+    snapshot.nb_columns = SCIPprobdataGetVars(probdata).size();
+    snapshot.nb_cuts = SCIPgetNCutsFound(scip);
+
+    // Get the memory usage.
+    snapshot.scip_memory = SCIPgetMemUsed(scip);
+    {
+        const auto& pool_stats = SCIPprobdataGetAStar(probdata).label_pool_statistics();
+        snapshot.label_pool_blocks = pool_stats.nb_blocks;
+        snapshot.label_pool_peak_bytes = pool_stats.peak_bytes;
+    }
+#if defined(USE_THREEVERTEX_CONFLICTS) || defined(USE_VERTEX_FOUREDGE_CONFLICTS)
+    for (const auto& fractional_vertices : SCIPprobdataGetFractionalVertices(probdata))
+    {
+        snapshot.nb_fractional_vertices += fractional_vertices.size();
+    }
+#endif
+    for (const auto& fractional_edges : SCIPprobdataGetFractionalEdges(probdata))
+    {
+        snapshot.nb_fractional_edges += fractional_edges.size();
+    }
+    snapshot.nb_robust_cuts = SCIPprobdataGetTwoAgentRobustCuts(probdata).size();
+    snapshot.memory = get_memory_usage(scip);
+    eventhdlrdata->prev_time = time;
+    eventhdlrdata->prev_nb_pricing_rounds = snapshot.nb_pricing_rounds;
+
+    // Hand over to the publishing thread.
+    {
+        std::lock_guard<std::mutex> lock(eventhdlrdata->mutex);
+        eventhdlrdata->snapshot = snapshot;
+        eventhdlrdata->has_snapshot = true;
+    }
+    eventhdlrdata->cv.notify_one();
+}
+
+// Start publishing (called when the branch-and-bound process is about to begin)
+static
+SCIP_DECL_EVENTINITSOL(eventInitsolTelemetry)
+{
+    // Check.
+    debug_assert(scip);
+    debug_assert(eventhdlr);
+
+    // Get event handler data.
+    auto eventhdlrdata = SCIPeventhdlrGetData(eventhdlr);
+    debug_assert(eventhdlrdata);
+
+    // Open the file or the socket.
+    const auto& path = eventhdlrdata->path;
+    if (path.compare(0, strlen(SOCKET_PREFIX), SOCKET_PREFIX) == 0)
+    {
+        const auto socket_path = path.substr(strlen(SOCKET_PREFIX));
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        release_assert(socket_path.size() < sizeof(address.sun_path),
+                       "Path to telemetry socket {} is too long", socket_path);
+        strcpy(address.sun_path, socket_path.c_str());
+
+        // Remove the socket left by an earlier run but never another file.
+        struct stat status;
+        if (lstat(socket_path.c_str(), &status) == 0)
+        {
+            release_assert(S_ISSOCK(status.st_mode),
+                           "Path to telemetry socket {} already exists and is not a socket", socket_path);
+            unlink(socket_path.c_str());
+        }
+
+        eventhdlrdata->listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        release_assert(eventhdlrdata->listen_fd >= 0, "Failed to create telemetry socket");
+        fcntl(eventhdlrdata->listen_fd, F_SETFL, O_NONBLOCK);
+        release_assert(bind(eventhdlrdata->listen_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0 &&
+                       listen(eventhdlrdata->listen_fd, 8) == 0,
+                       "Failed to open telemetry socket {}", socket_path);
+    }
+    else
+    {
+        eventhdlrdata->file = fopen(path.c_str(), "a");
+        release_assert(eventhdlrdata->file, "Failed to open telemetry file {}", path);
+    }
+
+    // Start the publishing thread.
+    eventhdlrdata->next_time = 0;
+    eventhdlrdata->prev_time = 0;
+    eventhdlrdata->prev_nb_pricing_rounds = 0;
+    eventhdlrdata->has_snapshot = false;
+    eventhdlrdata->stop = false;
+    eventhdlrdata->thread = std::thread(publish_loop, eventhdlrdata);
+
+    // Catch events.
+    SCIP_CALL(SCIPcatchEvent(scip, EVENTHDLR_TYPE, eventhdlr, nullptr, &eventhdlrdata->filterpos));
+
+    // Done.
+    return SCIP_OKAY;
+}
+
+// Stop publishing (called before the branch-and-bound process is freed)
+static
+SCIP_DECL_EVENTEXITSOL(eventExitsolTelemetry)
+{
+    // Check.
+    debug_assert(scip);
+    debug_assert(eventhdlr);
+
+    // Get event handler data.
+    auto eventhdlrdata = SCIPeventhdlrGetData(eventhdlr);
+    debug_assert(eventhdlrdata);
+
+    // Drop events.
+    SCIP_CALL(SCIPdropEvent(scip, EVENTHDLR_TYPE, eventhdlr, nullptr, eventhdlrdata->filterpos));
+    eventhdlrdata->filterpos = -1;
+
+    // Publish the final progress and stop the publishing thread.
+    take_snapshot(scip, eventhdlrdata, get_clock(scip));
+    {
+        std::lock_guard<std::mutex> lock(eventhdlrdata->mutex);
+        eventhdlrdata->stop = true;
+    }
+    eventhdlrdata->cv.notify_one();
+    eventhdlrdata->thread.join();
+
+    // Close the file or the socket.
+    if (eventhdlrdata->file)
+    {
+        fclose(eventhdlrdata->file);
+        eventhdlrdata->file = nullptr;
+    }
+    if (eventhdlrdata->listen_fd >= 0)
+    {
+        for (const auto& client : eventhdlrdata->clients)
+        {
+            close(client.fd);
+        }
+        eventhdlrdata->clients.clear();
+        close(eventhdlrdata->listen_fd);
+        eventhdlrdata->listen_fd = -1;
+        unlink(eventhdlrdata->path.substr(strlen(SOCKET_PREFIX)).c_str());
+    }
+
+    // Done.
+    return SCIP_OKAY;
+}
+
+// Free event handler
+static
+SCIP_DECL_EVENTFREE(eventFreeTelemetry)
+{
+    // Check.
+    debug_assert(scip);
+    debug_assert(eventhdlr);
+
+    // Get event handler data.
+    auto eventhdlrdata = SCIPeventhdlrGetData(eventhdlr);
+    debug_assert(eventhdlrdata);
+
+    // Deallocate.
+    eventhdlrdata->~SCIP_EventhdlrData();
+    SCIPfreeBlockMemory(scip, &eventhdlrdata);
+    SCIPeventhdlrSetData(eventhdlr, nullptr);
+
+    // Done.
+    return SCIP_OKAY;
+}
+
+// Take a snapshot if the interval has passed. Reading the clock is the only work done on most events.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+static
+SCIP_DECL_EVENTEXEC(eventExecTelemetry)
+{
+    // Check.
+    debug_assert(scip);
+    debug_assert(eventhdlr);
+
+    // Get event handler data.
+    auto eventhdlrdata = SCIPeventhdlrGetData(eventhdlr);
+    debug_assert(eventhdlrdata);
+
+    // Take a snapshot.
+    const auto time = get_clock(scip);
+    if (time >= eventhdlrdata->next_time)
+    {
+        take_snapshot(scip, eventhdlrdata, time);
+        eventhdlrdata->next_time = time + eventhdlrdata->interval;
+    }
+
+    // Done.
+    return SCIP_OKAY;
+}
+#pragma GCC diagnostic pop
+
+// Create event handler that periodically publishes the progress of the solver and include it
+SCIP_RETCODE SCIPincludeEventHdlrTelemetry(
+    SCIP* scip,                      // SCIP
+    const String& telemetry_path,    // Path to file or socket
+    const String& instance_file,     // Path to instance file
+    const SCIP_Real interval         // Seconds between messages
+)
+{
+    // Check.
+    debug_assert(scip);
+    release_assert(interval > 0, "Telemetry interval must be positive");
+
+    // Create event handler data.
+    SCIP_EventhdlrData* eventhdlrdata = nullptr;
+    SCIP_CALL(SCIPallocBlockMemory(scip, &eventhdlrdata));
+    new (eventhdlrdata) SCIP_EventhdlrData;
+    eventhdlrdata->path = telemetry_path;
+    eventhdlrdata->instance_file = instance_file;
+    eventhdlrdata->interval = interval;
+    eventhdlrdata->filterpos = -1;
+    eventhdlrdata->file = nullptr;
+    eventhdlrdata->listen_fd = -1;
+
+    // Include event handler.
+    SCIP_EVENTHDLR* eventhdlr = nullptr;
+    SCIP_CALL(SCIPincludeEventhdlrBasic(scip,
+                                        &eventhdlr,
+                                        EVENTHDLR_NAME,
+                                        EVENTHDLR_DESC,
+                                        eventExecTelemetry,
+                                        eventhdlrdata));
+    debug_assert(eventhdlr);
+
+    // Set callbacks.
+    SCIP_CALL(SCIPsetEventhdlrInitsol(scip, eventhdlr, eventInitsolTelemetry));
+    SCIP_CALL(SCIPsetEventhdlrExitsol(scip, eventhdlr, eventExitsolTelemetry));
+    SCIP_CALL(SCIPsetEventhdlrFree(scip, eventhdlr, eventFreeTelemetry));
+
+    // Done.
+    return SCIP_OKAY;
+}
@@ -0,0 +1,35 @@
+/*
+This file is part of BCP-MAPF.
+
+BCP-MAPF is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+BCP-MAPF is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+Author: Edward Lam <ed@ed-lam.com>
+*/
+
+
+#ifndef MAPF_EVENTHANDLER_TELEMETRY_H
+#define MAPF_EVENTHANDLER_TELEMETRY_H
+
+#include "Includes.h"
+
+// Create event handler that periodically publishes the progress of the solver and include it. The progress is
+// appended to an NDJSON file or, if the path starts with unix:, sent to every client of a Unix domain socket.
+SCIP_RETCODE SCIPincludeEventHdlrTelemetry(
+    SCIP* scip,                      // SCIP
+    const String& telemetry_path,    // Path to file or socket
+    const String& instance_file,     // Path to instance file
+    const SCIP_Real interval         // Seconds between messages
+);
+
+#endif
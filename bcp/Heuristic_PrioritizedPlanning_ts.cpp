@@ -778,7 +778,7 @@ SCIP_DECL_HEUREXEC(heurExecPrioritizedPlanning)
         debug_assert(astar.max_path_length() >= 1);
         earliest_goal_time = 0;
         latest_goal_time = astar.max_path_length() - 1;
-        latest_visit_time = map.latest_visit_time();
+        latest_visit_time.clear();
         for (Int c = 0; c < n_length_branching_conss; ++c)
         {
             // Get the constraint.
@@ -24,13 +24,15 @@ Author: Edward Lam <ed@ed-lam.com>
 
 #define OUTPUTS_DIR "outputs"
 #define ARTIFICIAL_VAR_COST                                 1e6
-#define PRICE_PRIORITY_DECAY_FACTOR                         1.3
+#define PRICING_STATISTICS_SMOOTHING                        0.3
+#define PRICING_MIN_TIME                                    1e-6
 #define CUT_VIOLATION                                       0.1
 
 // ---------------------------------------------------------------------------------------
 
 #include "Debug.h"
 #include "trufflehog/Includes.h"
+#include "trufflehog/Trace.h"
 #include <string>
 #include <memory>
 
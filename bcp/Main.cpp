@@ -20,172 +20,75 @@ Author: Edward Lam <ed@ed-lam.com>
 #include "Includes.h"
 #include "Reader.h"
 #include "Output.h"
+#include "Checkpoint.h"
+#include "EventHandler_Telemetry.h"
+#include "Memory.h"
+#include "Pricer_TruffleHog.h"
+#include "ProblemData.h"
+#include "VariableData.h"
 
 #include "scip/scipshell.h"
 #include "scip/scipdefplugins.h"
 #include "cxxopts.hpp"
+#include <csignal>
+#include <fstream>
+#include <sstream>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
-static
-SCIP_RETCODE start_solver(
-    int argc,      // Number of shell parameters
-    char** argv    // Array with shell parameters
-)
+// Settings of one run of the solver
+struct Job
 {
-    // Parse program options.
-    String instance_file;
-    Agent agent_limit = std::numeric_limits<Agent>::max();
-    SCIP_Real time_limit = 0;
-    SCIP_Longint node_limit = 0;
-    SCIP_Real gap_limit = 0;
-    int time_spacing = 0;
-    try
-    {
-        // Create program options.
-        cxxopts::Options options(argv[0],
-                                 "BCP-MAPF - branch-and-cut-and-price for multi-agent path finding");
-        options.positional_help("instance_file").show_positional_help();
-        options.add_options()
-            ("help", "Print help")
-            ("f,file", "Path to instance file", cxxopts::value<String>())
-            ("a,agent-limit", "Read the first several agents only", cxxopts::value<Agent>())
-            ("t,time-limit", "Time limit in seconds", cxxopts::value<SCIP_Real>())
-            ("n,node-limit", "Maximum number of branch-and-bound nodes", cxxopts::value<SCIP_Longint>())
-            ("g,gap-limit", "Solve to an optimality gap", cxxopts::value<SCIP_Real>())
-            ("s,time-spacing", "Time-spacing parameter", cxxopts::value<int>())
-        ;
-        options.parse_positional({"file"});
-
-        // Parse options.
-        auto result = options.parse(argc, argv);
-
-        // Print help.
-        if (result.count("help") || !result.count("file"))
-        {
-            println("{}", options.help());
-            exit(0);
-        }
-
-        // Get path to instance.
-        if (result.count("file"))
-        {
-            instance_file = result["file"].as<String>();
-        }
-
-        // Get agent limit.
-        if (result.count("agent-limit"))
-        {
-            agent_limit = result["agent-limit"].as<Agent>();
-        }
-
-        // Get time limit.
-        if (result.count("time-limit"))
-        {
-            time_limit = result["time-limit"].as<SCIP_Real>();
-        }
-
-        // Get node limit.
-        if (result.count("node-limit"))
-        {
-            node_limit = result["node-limit"].as<SCIP_Longint>();
-        }
-
-        // Get optimality gap limit.
-        if (result.count("gap-limit"))
-        {
-            gap_limit = result["gap-limit"].as<SCIP_Real>();
-        }
-
-        if (result.count("time-spacing"))
-        {
-            time_spacing = result["time-spacing"].as<int>();
-        }
-    }
-    catch (const cxxopts::OptionException& e)
-    {
-        err("{}", e.what());
-    }
-
-    // Print.
-    println("Branch-and-cut-and-price for multi-agent path finding");
-    println("Edward Lam <ed@ed-lam.com>");
-    println("Monash University, Melbourne, Australia");
+    String instance_file;       // Path to instance file
+    Agent agent_limit;          // Number of agents to read
+    int time_spacing;           // Time-spacing parameter
+    SCIP_Real time_limit;       // Time limit in seconds
+    SCIP_Longint node_limit;    // Maximum number of branch-and-bound nodes
+    SCIP_Real gap_limit;        // Optimality gap limit
+    SCIP_Real memory_limit;     // Memory limit in megabytes
+    SCIP_Real frontier_memory;  // Megabytes of memory of the dense layers of the frontiers of the pricer
+    int label_pool_block_size;  // Megabytes of each block of labels of the pricer
+    String solution_file;       // Path to solution file to start from
+    String best_solution_file;  // Path to file to write the best solution to
+    String checkpoint_file;     // Path to checkpoint to write when solving stops
+    String resume_file;         // Path to checkpoint to resume from
+    String report_file;         // Path to file to append a record of the run to
+    String telemetry_path;      // Path to file or socket to publish progress to
+    SCIP_Real telemetry_period; // Seconds between progress messages
+    String trace_file;          // Path to file to write the traced scopes to
+};
 
+// Outcome of one run of the solver
+struct JobResult
+{
+    SCIP_STATUS status;         // Solution status
+    SCIP_Real primal_bound;     // Cost of the best solution
+    SCIP_Real dual_bound;       // Lower bound
+    SCIP_Real gap;              // Optimality gap
+    SCIP_Longint nb_nodes;      // Number of branch-and-bound nodes
+    SCIP_Real time;             // Solving time in seconds
+};
 
-#ifdef USE_OLD_TIME_SPACING
-    println("Using old time-spacing constraints");
-#endif
-#ifdef USE_NEW_TIME_SPACING
-    println("Using new time-spacing constraints");
-#endif
+// Path of an agent
+using Column = Pair<Agent, Vector<Edge>>;
 
-#ifdef DEBUG
-    println("Compiled in debug mode");
-#ifdef USE_WAITEDGE_CONFLICTS
-    println("Using wait-edge conflict constraints");
-#endif
-#ifdef USE_RECTANGLE_KNAPSACK_CONFLICTS
-    println("Using rectangle knapsack conflict constraints");
-#endif
-#ifdef USE_RECTANGLE_CLIQUE_CONFLICTS
-    println("Using rectangle clique conflict constraints");
-#endif
-#if !defined(USE_WAITCORRIDOR_CONFLICTS) && defined(USE_CORRIDOR_CONFLICTS)
-    println("Using corridor conflict constraints");
-#endif
-#ifdef USE_WAITCORRIDOR_CONFLICTS
-    println("Using wait corridor conflict constraints");
-#endif
-#ifdef USE_STEPASIDE_CONFLICTS
-    println("Using step aside conflict constraints");
-#endif
-#ifdef USE_WAITDELAY_CONFLICTS
-    println("Using wait delay conflict constraints");
-#endif
-#ifdef USE_EXITENTRY_CONFLICTS
-    println("Using exit entry conflict constraints");
-#endif
-#if !defined(USE_WAITTWOEDGE_CONFLICTS) && defined(USE_TWOEDGE_CONFLICTS)
-    println("Using two edge conflict constraints");
-#endif
-#ifdef USE_WAITTWOEDGE_CONFLICTS
-    println("Using wait two edge conflict constraints");
-#endif
-#ifdef USE_AGENTWAITEDGE_CONFLICTS
-    println("Using agent wait edge conflict constraints");
-#endif
-#ifdef USE_TWOVERTEX_CONFLICTS
-    println("Using two vertex conflict constraints");
-#endif
-#ifdef USE_THREEVERTEX_CONFLICTS
-    println("Using three vertex conflict constraints");
-#endif
-#ifdef USE_FOUREDGE_CONFLICTS
-    println("Using four edge conflict constraints");
-#endif
-#ifdef USE_FIVEEDGE_CONFLICTS
-    println("Using five edge conflict constraints");
-#endif
-#ifdef USE_SIXEDGE_CONFLICTS
-    println("Using six edge conflict constraints");
-#endif
-#ifdef USE_VERTEX_FOUREDGE_CONFLICTS
-    println("Using vertex four edge conflict constraints");
-#endif
-#ifdef USE_CLIQUE_CONFLICTS
-    println("Using clique conflict constraints");
-#endif
-#ifdef USE_GOAL_CONFLICTS
-    println("Using goal conflict constraints");
-#endif
-#ifdef USE_PATH_LENGTH_NOGOODS
-    println("Using path length nogoods");
-#endif
-#endif
-    println("");
+// Forward a termination request to the interrupt handler of SCIP so that solving stops as after Ctrl-C
+static
+void interrupt_on_sigterm(int)
+{
+    raise(SIGINT);
+}
 
+// Create SCIP with the plugins and parameters
+static
+SCIP_RETCODE create_solver(
+    SCIP** scip_ptr    // Output SCIP
+)
+{
     // Initialize SCIP.
-    SCIP* scip = nullptr;
-    SCIP_CALL(SCIPcreate(&scip));
+    SCIP_CALL(SCIPcreate(scip_ptr));
+    auto scip = *scip_ptr;
 
     // Set up plugins.
     {
@@ -367,39 +270,179 @@ SCIP_RETCODE start_solver(
         }
     }
 
+    // Done.
+    return SCIP_OKAY;
+}
+
+// Solve one instance. If columns are given, add the columns of agents in the instance before solving and replace them
+// by the columns of the master problem afterwards.
+static
+SCIP_RETCODE solve_job(
+    const Job& job,             // Instance and limits
+    InstanceCache* cache,       // Maps and lower bounds of previous instances
+    Vector<Column>* columns,    // Columns of a previous run
+    JobResult& result           // Output outcome
+)
+{
+    // Start recording the traced scopes.
+#ifdef USE_TRACING
+    if (!job.trace_file.empty())
+    {
+        start_trace(job.trace_file);
+    }
+#endif
+
+    // Create SCIP.
+    SCIP* scip = nullptr;
+    SCIP_CALL(create_solver(&scip));
+
+    // Publish progress.
+    if (!job.telemetry_path.empty())
+    {
+        SCIP_CALL(SCIPincludeEventHdlrTelemetry(scip, job.telemetry_path, job.instance_file, job.telemetry_period));
+    }
+
     // Read instance.
-    release_assert(agent_limit > 0, "Cannot limit to {} number of agents", agent_limit);
-    SCIP_CALL(read_instance(scip, instance_file.c_str(), agent_limit, time_spacing));
+    release_assert(job.agent_limit > 0, "Cannot limit to {} number of agents", job.agent_limit);
+    SCIP_CALL(read_instance(scip, job.instance_file.c_str(), job.agent_limit, job.time_spacing, cache));
 
     // Set time limit.
-    if (time_limit > 0)
+    if (job.time_limit > 0)
     {
-        SCIP_CALL(SCIPsetRealParam(scip, "limits/time", time_limit));
+        SCIP_CALL(SCIPsetRealParam(scip, "limits/time", job.time_limit));
     }
 
     // Set node limit.
-    if (node_limit > 0)
+    if (job.node_limit > 0)
     {
-        SCIP_CALL(SCIPsetLongintParam(scip, "limits/nodes", node_limit));
+        SCIP_CALL(SCIPsetLongintParam(scip, "limits/nodes", job.node_limit));
     }
 
     // Set optimality gap limit.
-    if (gap_limit > 0)
+    if (job.gap_limit > 0)
+    {
+        SCIP_CALL(SCIPsetRealParam(scip, "limits/gap", job.gap_limit));
+    }
+
+    // Set memory limit. The caches of the pricer are freed when the memory used reaches the limit, and SCIP stops
+    // when its own memory reaches the limit.
+    if (job.memory_limit > 0)
     {
-        SCIP_CALL(SCIPsetRealParam(scip, "limits/gap", gap_limit));
+        SCIP_CALL(SCIPsetRealParam(scip, "pricers/trufflehog/memorybudget", job.memory_limit));
+        SCIP_CALL(SCIPsetRealParam(scip, "limits/memory", job.memory_limit));
     }
 
-    // Solve.
+    // Set the memory of the dense layers of the frontiers.
+    if (job.frontier_memory > 0)
+    {
+        SCIP_CALL(SCIPsetRealParam(scip, "pricers/trufflehog/frontiermemory", job.frontier_memory));
+    }
+
+    // Set the size of the blocks of labels.
+    if (job.label_pool_block_size > 0)
+    {
+        SCIP_CALL(SCIPsetIntParam(scip, "pricers/trufflehog/labelpoolblocksize", job.label_pool_block_size));
+    }
+
+    // Check if the checkpoint exists. The same command can be used to start and to resume.
+    bool resume = false;
+    if (!job.resume_file.empty())
+    {
+        resume = std::filesystem::exists(job.resume_file);
+        if (!resume)
+        {
+            println("Checkpoint {} is not found. Starting from scratch", job.resume_file);
+        }
+    }
+
+    // Add the columns of a previous run, the checkpoint and the initial solution after transforming the problem since
+    // the constraints only accept transformed variables.
+    if (columns || resume || !job.solution_file.empty())
+    {
+        SCIP_CALL(SCIPpresolve(scip));
+    }
+    if (columns)
+    {
+        auto probdata = SCIPgetProbData(scip);
+        const auto N = SCIPprobdataGetN(probdata);
+        Int nb_added = 0;
+        for (const auto& [a, path] : *columns)
+            if (a < N)
+            {
+                SCIP_VAR* var = nullptr;
+                SCIP_CALL(SCIPprobdataAddInitialVar(scip, probdata, a, path.size(), path.data(), &var));
+                debug_assert(var);
+                nb_added++;
+            }
+        println("Added {} columns of the previous run", nb_added);
+    }
+    if (resume)
+    {
+        SCIP_CALL(read_checkpoint(scip, job.resume_file));
+    }
+    if (!job.solution_file.empty())
+    {
+        SCIP_CALL(read_initial_solution(scip, job.solution_file));
+    }
+
+    // Solve. A termination request, for example from a batch system preempting the run, stops solving like Ctrl-C so
+    // that the checkpoint is written.
+    const auto previous_sigterm_handler = std::signal(SIGTERM, interrupt_on_sigterm);
     SCIP_CALL(SCIPsolve(scip));
+    std::signal(SIGTERM, previous_sigterm_handler);
+
+    // Write the remaining traced scopes.
+#ifdef USE_TRACING
+    stop_trace();
+#endif
+
+    // Write checkpoint.
+    if (!job.checkpoint_file.empty())
+    {
+        SCIP_CALL(write_checkpoint(scip, job.checkpoint_file));
+    }
+
+    // Store the columns.
+    if (columns)
+    {
+        columns->clear();
+        for (const auto& [var, _] : SCIPprobdataGetVars(SCIPgetProbData(scip)))
+        {
+            auto vardata = SCIPvarGetData(var);
+            const auto path_length = SCIPvardataGetPathLength(vardata);
+            const auto path = SCIPvardataGetPath(vardata);
+            columns->emplace_back(SCIPvardataGetAgent(vardata), Vector<Edge>(path, path + path_length));
+        }
+    }
 
     // Output.
     {
         // Print.
         println("");
         SCIP_CALL(SCIPprintStatistics(scip, NULL));
+        println("");
+        SCIP_CALL(SCIPpricerTruffleHogPrintStatistics(scip));
+        print_memory_usage(scip);
+
+        // Write best solution to file.
+        if (!job.best_solution_file.empty())
+        {
+            SCIP_CALL(write_best_solution(scip, job.best_solution_file));
+        }
+
+        // Write report.
+        if (!job.report_file.empty())
+        {
+            SCIP_CALL(write_report(scip, job.report_file, job.instance_file, job.time_spacing));
+        }
 
-        // // Write best solution to file.
-        // SCIP_CALL(write_best_solution(scip));
+        // Store the outcome.
+        result.status = SCIPgetStatus(scip);
+        result.primal_bound = SCIPgetPrimalbound(scip);
+        result.dual_bound = SCIPgetDualbound(scip);
+        result.gap = SCIPgetGap(scip);
+        result.nb_nodes = SCIPgetNNodes(scip);
+        result.time = SCIPgetSolvingTime(scip);
     }
 
     // Free memory.
@@ -412,6 +455,585 @@ SCIP_RETCODE start_solver(
     return SCIP_OKAY;
 }
 
+// Write the outcome of a job in one line so that processes can append to the same file
+static
+void write_result(
+    FILE* result_file,          // File of results
+    const Job& job,             // Instance and limits
+    const JobResult& result     // Outcome
+)
+{
+    const auto record = fmt::format("{},{},{},{},{},{},{},{},{:.3f}\n",
+                                    csv_string(job.instance_file),
+                                    job.agent_limit < std::numeric_limits<Agent>::max() ? job.agent_limit : -1,
+                                    job.time_spacing,
+                                    csv_string(status_name(result.status)),
+                                    result.primal_bound,
+                                    result.dual_bound,
+                                    result.gap,
+                                    result.nb_nodes,
+                                    result.time);
+    fputs(record.c_str(), result_file);
+    fflush(result_file);
+}
+
+// Write a line for a job whose worker stopped while solving it
+static
+void write_failure(
+    FILE* result_file,          // File of results
+    const Job& job              // Instance and limits
+)
+{
+    const auto record = fmt::format("{},{},{},\"failed\",,,,,\n",
+                                    csv_string(job.instance_file),
+                                    job.agent_limit < std::numeric_limits<Agent>::max() ? job.agent_limit : -1,
+                                    job.time_spacing);
+    fputs(record.c_str(), result_file);
+    fflush(result_file);
+}
+
+// Solve an instance with increasing numbers of agents, starting each run from the columns of the previous run
+static
+SCIP_RETCODE solve_incremental(
+    const Job& job,                       // Instance and limits
+    const Vector<Agent>& agent_steps      // Numbers of agents
+)
+{
+    // Solve each step.
+    InstanceCache cache;
+    Vector<Column> columns;
+    Vector<JobResult> results(agent_steps.size());
+    for (size_t step = 0; step < agent_steps.size(); ++step)
+    {
+        auto step_job = job;
+        step_job.agent_limit = agent_steps[step];
+        step_job.checkpoint_file.clear();
+        step_job.resume_file.clear();
+        step_job.trace_file.clear();
+        println("Solving with {} agents", step_job.agent_limit);
+        SCIP_CALL(solve_job(step_job, &cache, &columns, results[step]));
+        println("");
+    }
+
+    // Print the time of each step.
+    println("{:>8s} {:>14s} {:>12s} {:>12s} {:>10s}", "Agents", "Status", "Primal", "Dual", "Time");
+    for (size_t step = 0; step < agent_steps.size(); ++step)
+    {
+        const auto& result = results[step];
+        println("{:>8d} {:>14s} {:>12.2f} {:>12.2f} {:>10.2f}",
+                agent_steps[step],
+                status_name(result.status),
+                result.primal_bound,
+                result.dual_bound,
+                result.time);
+    }
+
+    // Done.
+    return SCIP_OKAY;
+}
+
+// Read the jobs of a batch. Each line holds the instance file and optionally the agent limit, the time-spacing
+// parameter and the time limit, which default to the settings of the command line.
+static
+Vector<Job> read_manifest(
+    const String& manifest_file,    // Path to manifest file
+    const Job& default_job          // Settings of the command line
+)
+{
+    std::ifstream file(manifest_file);
+    release_assert(file.good(), "Cannot find manifest file {}", manifest_file);
+
+    Vector<Job> jobs;
+    String line;
+    while (std::getline(file, line))
+    {
+        // Skip empty lines and comments.
+        std::istringstream line_stream(line);
+        auto job = default_job;
+        job.solution_file.clear();
+        job.best_solution_file.clear();
+        job.checkpoint_file.clear();
+        job.resume_file.clear();
+        job.trace_file.clear();
+        if (!(line_stream >> job.instance_file) || job.instance_file[0] == '#')
+        {
+            continue;
+        }
+
+        // Read the limits.
+        if (Agent agent_limit; line_stream >> agent_limit)
+        {
+            job.agent_limit = agent_limit;
+            if (int time_spacing; line_stream >> time_spacing)
+            {
+                job.time_spacing = time_spacing;
+                if (SCIP_Real time_limit; line_stream >> time_limit)
+                {
+                    job.time_limit = time_limit;
+                }
+            }
+        }
+        jobs.push_back(job);
+    }
+    return jobs;
+}
+
+// Progress of a worker process, shared with the parent process
+struct WorkerProgress
+{
+    Int current_job;    // Index of the job being solved or -1 between jobs
+};
+
+// Solve every job assigned to a worker in turn, sharing the maps and lower bounds between the jobs
+static
+SCIP_RETCODE solve_jobs(
+    const Vector<Job>& jobs,              // Jobs of the batch
+    const Int worker,                     // Index of the worker
+    const Int nb_workers,                 // Number of workers
+    const Int first_job,                  // Index of the first job to solve
+    const String& result_path,            // Path to file of results
+    volatile WorkerProgress* progress     // Output progress of the worker
+)
+{
+    auto result_file = fopen(result_path.c_str(), "a");
+    release_assert(result_file, "Cannot open result file {}", result_path);
+    InstanceCache cache;
+    for (Int idx = first_job; idx < static_cast<Int>(jobs.size()); idx += nb_workers)
+    {
+        println("Solving job {} of {}: {}", idx + 1, jobs.size(), jobs[idx].instance_file);
+        auto job = jobs[idx];
+        if (nb_workers > 1 && !job.telemetry_path.empty())
+        {
+            job.telemetry_path += fmt::format(".{}", worker);
+        }
+        progress->current_job = idx;
+        JobResult result;
+        SCIP_CALL(solve_job(job, &cache, nullptr, result));
+        write_result(result_file, jobs[idx], result);
+        progress->current_job = -1;
+        println("");
+    }
+    fclose(result_file);
+    return SCIP_OKAY;
+}
+
+// Start a worker process to solve its jobs from a given job onwards
+static
+pid_t start_worker(
+    const Vector<Job>& jobs,              // Jobs of the batch
+    const Int worker,                     // Index of the worker
+    const Int nb_workers,                 // Number of workers
+    const Int first_job,                  // Index of the first job to solve
+    const String& result_path,            // Path to file of results
+    volatile WorkerProgress* progress     // Output progress of the worker
+)
+{
+    fflush(stdout);
+    progress->current_job = -1;
+    const auto pid = fork();
+    release_assert(pid >= 0, "Failed to start worker process {}", worker);
+    if (pid == 0)
+    {
+        const auto retcode = solve_jobs(jobs, worker, nb_workers, first_job, result_path, progress);
+        if (retcode != SCIP_OKAY)
+        {
+            SCIPprintError(retcode);
+        }
+        exit(retcode == SCIP_OKAY ? 0 : 1);
+    }
+    return pid;
+}
+
+// Solve the jobs of a batch in worker processes. A job that stops its worker, for example with a failed assertion,
+// is recorded as failed and a new worker continues with the next jobs of the worker. Returns an error if any job
+// failed.
+static
+SCIP_RETCODE solve_batch(
+    const Vector<Job>& jobs,        // Jobs of the batch
+    Int nb_workers,                 // Number of processes
+    const String& result_path       // Path to file of results
+)
+{
+    // Write the header of the result file.
+    {
+        auto result_file = fopen(result_path.c_str(), "w");
+        release_assert(result_file, "Cannot open result file {}", result_path);
+        fputs("instance,agents,time_spacing,status,primal_bound,dual_bound,gap,nodes,time\n", result_file);
+        fclose(result_file);
+    }
+
+    // Write the header of the report file before the workers start so that they do not each write it.
+    for (const auto& job : jobs)
+        if (!job.report_file.empty())
+        {
+            write_report_header(job.report_file);
+        }
+
+    // Create the progress of the workers in memory shared with the workers.
+    nb_workers = std::max<Int>(nb_workers, 1);
+    auto progress = static_cast<volatile WorkerProgress*>(mmap(nullptr,
+                                                               sizeof(WorkerProgress) * nb_workers,
+                                                               PROT_READ | PROT_WRITE,
+                                                               MAP_SHARED | MAP_ANONYMOUS,
+                                                               -1,
+                                                               0));
+    release_assert(progress != MAP_FAILED, "Failed to share the progress of the workers");
+
+    // Start the worker processes.
+    Vector<pid_t> pids(nb_workers);
+    for (Int worker = 0; worker < nb_workers; ++worker)
+    {
+        pids[worker] = start_worker(jobs, worker, nb_workers, worker, result_path, &progress[worker]);
+    }
+
+    // Wait for the workers to finish. Restart a worker after the job it failed on.
+    Int nb_failed = 0;
+    for (Int nb_running = nb_workers; nb_running > 0;)
+    {
+        int status = 0;
+        const auto pid = wait(&status);
+        release_assert(pid > 0, "Failed to wait for the worker processes");
+        const auto it = std::find(pids.begin(), pids.end(), pid);
+        if (it == pids.end())
+        {
+            continue;
+        }
+        const Int worker = it - pids.begin();
+        nb_running--;
+        if (WIFEXITED(status) && WEXITSTATUS(status) == 0)
+        {
+            continue;
+        }
+
+        // Record the failure.
+        nb_failed++;
+        const Int failed_job = progress[worker].current_job;
+        if (failed_job < 0)
+        {
+            println("Worker process {} failed between jobs", worker);
+            continue;
+        }
+        println("Worker process {} failed on job {}: {}", worker, failed_job + 1, jobs[failed_job].instance_file);
+        {
+            auto result_file = fopen(result_path.c_str(), "a");
+            release_assert(result_file, "Cannot open result file {}", result_path);
+            write_failure(result_file, jobs[failed_job]);
+            fclose(result_file);
+        }
+
+        // Continue with the next job of the worker.
+        if (const auto next_job = failed_job + nb_workers; next_job < static_cast<Int>(jobs.size()))
+        {
+            pids[worker] = start_worker(jobs, worker, nb_workers, next_job, result_path, &progress[worker]);
+            nb_running++;
+        }
+    }
+    munmap(const_cast<WorkerProgress*>(progress), sizeof(WorkerProgress) * nb_workers);
+
+    // Done.
+    if (nb_failed > 0)
+    {
+        println("Workers of the batch failed {} times", nb_failed);
+        return SCIP_ERROR;
+    }
+    return SCIP_OKAY;
+}
+
+static
+SCIP_RETCODE start_solver(
+    int argc,      // Number of shell parameters
+    char** argv    // Array with shell parameters
+)
+{
+    // Parse program options.
+    Job job{"", std::numeric_limits<Agent>::max(), 0, 0, 0, 0, 0, 0, 0, "", "", "", "", "", "", 1.0, ""};
+    Vector<Agent> agent_steps;
+    String manifest_file;
+    String result_file;
+    Int nb_workers = 1;
+    String binary_file;
+    try
+    {
+        // Create program options.
+        cxxopts::Options options(argv[0],
+                                 "BCP-MAPF - branch-and-cut-and-price for multi-agent path finding");
+        options.positional_help("instance_file").show_positional_help();
+        options.add_options()
+            ("help", "Print help")
+            ("f,file", "Path to instance file", cxxopts::value<String>())
+            ("a,agent-limit", "Read the first several agents only", cxxopts::value<Agent>())
+            ("t,time-limit", "Time limit in seconds", cxxopts::value<SCIP_Real>())
+            ("n,node-limit", "Maximum number of branch-and-bound nodes", cxxopts::value<SCIP_Longint>())
+            ("g,gap-limit", "Solve to an optimality gap", cxxopts::value<SCIP_Real>())
+            ("memory-limit", "Memory limit in megabytes, freeing the caches of the pricer first", cxxopts::value<SCIP_Real>())
+            ("frontier-memory", "Megabytes of memory of the dense frontiers of the pricer", cxxopts::value<SCIP_Real>())
+            ("label-pool-block-size", "Megabytes of each block of labels of the pricer", cxxopts::value<int>())
+            ("s,time-spacing", "Time-spacing parameter", cxxopts::value<int>())
+            ("initial-solution", "Path to solution file to start from", cxxopts::value<String>())
+            ("write-solution", "Path to file to write the best solution to", cxxopts::value<String>())
+            ("checkpoint", "Path to checkpoint to save when solving stops", cxxopts::value<String>())
+            ("resume", "Path to checkpoint to resume from if it exists", cxxopts::value<String>())
+            ("agent-steps", "Solve with each number of agents in turn, reusing columns", cxxopts::value<Vector<Agent>>())
+            ("batch", "Path to manifest file of instances to solve in one process", cxxopts::value<String>())
+            ("batch-output", "Path to file of results of the batch", cxxopts::value<String>())
+            ("batch-workers", "Number of processes solving the batch", cxxopts::value<Int>())
+            ("report", "Path to file to append a record of the run to", cxxopts::value<String>())
+            ("telemetry", "Path to file, or unix: and path to socket, to publish progress to", cxxopts::value<String>())
+            ("telemetry-interval", "Seconds between progress messages", cxxopts::value<SCIP_Real>())
+            ("write-binary", "Convert the instance to the binary format and exit", cxxopts::value<String>())
+        ;
+#ifdef USE_TRACING
+        options.add_options()
+            ("trace", "Path to file to write the traced scopes to in the Chrome trace event format", cxxopts::value<String>())
+        ;
+#endif
+        options.parse_positional({"file"});
+
+        // Parse options.
+        auto result = options.parse(argc, argv);
+
+        // Print help.
+        if (result.count("help") || (!result.count("file") && !result.count("batch")))
+        {
+            println("{}", options.help());
+            exit(0);
+        }
+
+        // Get path to instance.
+        if (result.count("file"))
+        {
+            job.instance_file = result["file"].as<String>();
+        }
+
+        // Get agent limit.
+        if (result.count("agent-limit"))
+        {
+            job.agent_limit = result["agent-limit"].as<Agent>();
+        }
+
+        // Get time limit.
+        if (result.count("time-limit"))
+        {
+            job.time_limit = result["time-limit"].as<SCIP_Real>();
+        }
+
+        // Get node limit.
+        if (result.count("node-limit"))
+        {
+            job.node_limit = result["node-limit"].as<SCIP_Longint>();
+        }
+
+        // Get optimality gap limit.
+        if (result.count("gap-limit"))
+        {
+            job.gap_limit = result["gap-limit"].as<SCIP_Real>();
+        }
+
+        // Get memory limit.
+        if (result.count("memory-limit"))
+        {
+            job.memory_limit = result["memory-limit"].as<SCIP_Real>();
+        }
+        if (result.count("frontier-memory"))
+        {
+            job.frontier_memory = result["frontier-memory"].as<SCIP_Real>();
+        }
+        if (result.count("label-pool-block-size"))
+        {
+            job.label_pool_block_size = result["label-pool-block-size"].as<int>();
+        }
+
+        if (result.count("time-spacing"))
+        {
+            job.time_spacing = result["time-spacing"].as<int>();
+        }
+
+        // Get initial solution.
+        if (result.count("initial-solution"))
+        {
+            job.solution_file = result["initial-solution"].as<String>();
+        }
+
+        // Get path to write the best solution to.
+        if (result.count("write-solution"))
+        {
+            job.best_solution_file = result["write-solution"].as<String>();
+        }
+
+        // Get checkpoint files.
+        if (result.count("checkpoint"))
+        {
+            job.checkpoint_file = result["checkpoint"].as<String>();
+        }
+        if (result.count("resume"))
+        {
+            job.resume_file = result["resume"].as<String>();
+        }
+
+        // Get path to report.
+        if (result.count("report"))
+        {
+            job.report_file = result["report"].as<String>();
+        }
+
+        // Get telemetry.
+        if (result.count("telemetry"))
+        {
+            job.telemetry_path = result["telemetry"].as<String>();
+        }
+        if (result.count("telemetry-interval"))
+        {
+            job.telemetry_period = result["telemetry-interval"].as<SCIP_Real>();
+        }
+
+        // Get path to trace.
+#ifdef USE_TRACING
+        if (result.count("trace"))
+        {
+            job.trace_file = result["trace"].as<String>();
+        }
+#endif
+
+        // Get numbers of agents to solve in turn.
+        if (result.count("agent-steps"))
+        {
+            agent_steps = result["agent-steps"].as<Vector<Agent>>();
+        }
+
+        // Get batch.
+        if (result.count("batch"))
+        {
+            manifest_file = result["batch"].as<String>();
+            result_file = manifest_file + ".csv";
+        }
+        if (result.count("batch-output"))
+        {
+            result_file = result["batch-output"].as<String>();
+        }
+        if (result.count("batch-workers"))
+        {
+            nb_workers = result["batch-workers"].as<Int>();
+        }
+
+        // Get path to binary instance.
+        if (result.count("write-binary"))
+        {
+            binary_file = result["write-binary"].as<String>();
+        }
+    }
+    catch (const cxxopts::OptionException& e)
+    {
+        err("{}", e.what());
+    }
+
+    // Print.
+    println("Branch-and-cut-and-price for multi-agent path finding");
+    println("Edward Lam <ed@ed-lam.com>");
+    println("Monash University, Melbourne, Australia");
+
+
+#ifdef USE_OLD_TIME_SPACING
+    println("Using old time-spacing constraints");
+#endif
+#ifdef USE_NEW_TIME_SPACING
+    println("Using new time-spacing constraints");
+#endif
+
+#ifdef DEBUG
+    println("Compiled in debug mode");
+#ifdef USE_WAITEDGE_CONFLICTS
+    println("Using wait-edge conflict constraints");
+#endif
+#ifdef USE_RECTANGLE_KNAPSACK_CONFLICTS
+    println("Using rectangle knapsack conflict constraints");
+#endif
+#ifdef USE_RECTANGLE_CLIQUE_CONFLICTS
+    println("Using rectangle clique conflict constraints");
+#endif
+#if !defined(USE_WAITCORRIDOR_CONFLICTS) && defined(USE_CORRIDOR_CONFLICTS)
+    println("Using corridor conflict constraints");
+#endif
+#ifdef USE_WAITCORRIDOR_CONFLICTS
+    println("Using wait corridor conflict constraints");
+#endif
+#ifdef USE_STEPASIDE_CONFLICTS
+    println("Using step aside conflict constraints");
+#endif
+#ifdef USE_WAITDELAY_CONFLICTS
+    println("Using wait delay conflict constraints");
+#endif
+#ifdef USE_EXITENTRY_CONFLICTS
+    println("Using exit entry conflict constraints");
+#endif
+#if !defined(USE_WAITTWOEDGE_CONFLICTS) && defined(USE_TWOEDGE_CONFLICTS)
+    println("Using two edge conflict constraints");
+#endif
+#ifdef USE_WAITTWOEDGE_CONFLICTS
+    println("Using wait two edge conflict constraints");
+#endif
+#ifdef USE_AGENTWAITEDGE_CONFLICTS
+    println("Using agent wait edge conflict constraints");
+#endif
+#ifdef USE_TWOVERTEX_CONFLICTS
+    println("Using two vertex conflict constraints");
+#endif
+#ifdef USE_THREEVERTEX_CONFLICTS
+    println("Using three vertex conflict constraints");
+#endif
+#ifdef USE_FOUREDGE_CONFLICTS
+    println("Using four edge conflict constraints");
+#endif
+#ifdef USE_FIVEEDGE_CONFLICTS
+    println("Using five edge conflict constraints");
+#endif
+#ifdef USE_SIXEDGE_CONFLICTS
+    println("Using six edge conflict constraints");
+#endif
+#ifdef USE_VERTEX_FOUREDGE_CONFLICTS
+    println("Using vertex four edge conflict constraints");
+#endif
+#ifdef USE_CLIQUE_CONFLICTS
+    println("Using clique conflict constraints");
+#endif
+#ifdef USE_GOAL_CONFLICTS
+    println("Using goal conflict constraints");
+#endif
+#ifdef USE_PATH_LENGTH_NOGOODS
+    println("Using path length nogoods");
+#endif
+#endif
+#ifdef USE_TRACING
+    println("Compiled with tracing");
+#endif
+    println("");
+
+    // Convert an instance to the binary format.
+    if (!binary_file.empty())
+    {
+        const Instance instance(job.instance_file, job.agent_limit);
+        instance.write_binary(binary_file);
+        println("Wrote {} agents on map {} to {}", instance.agents.size(), instance.map_path.string(), binary_file);
+        return SCIP_OKAY;
+    }
+
+    // Solve a batch of instances.
+    if (!manifest_file.empty())
+    {
+        const auto jobs = read_manifest(manifest_file, job);
+        return solve_batch(jobs, nb_workers, result_file);
+    }
+
+    // Solve an instance with increasing numbers of agents.
+    if (!agent_steps.empty())
+    {
+        return solve_incremental(job, agent_steps);
+    }
+
+    // Solve one instance.
+    JobResult result;
+    return solve_job(job, nullptr, nullptr, result);
+}
+
 int main(int argc, char** argv)
 {
     const SCIP_RETCODE retcode = start_solver(argc, argv);
@@ -0,0 +1,207 @@
+/*
+This file is part of BCP-MAPF.
+
+BCP-MAPF is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+BCP-MAPF is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+Author: Edward Lam <ed@ed-lam.com>
+*/
+
+#include "Memory.h"
+#include "ProblemData.h"
+#include "VariableData.h"
+#include "Pricer_TruffleHog.h"
+
+#define BYTES_PER_MEGABYTE (1024.0 * 1024.0)
+
+// Estimate the memory used by the solver
+MemoryUsage get_memory_usage(
+    SCIP* scip    // SCIP
+)
+{
+    // Check.
+    debug_assert(scip);
+
+    // Get problem data.
+    auto probdata = SCIPgetProbData(scip);
+    debug_assert(probdata);
+    const auto N = SCIPprobdataGetN(probdata);
+    const auto& astar = SCIPprobdataGetAStar(probdata);
+
+    // Get the memory of SCIP and the pricer.
+    MemoryUsage usage{};
+    usage.scip = SCIPgetMemUsed(scip);
+    usage.label_pools = astar.label_pool_bytes();
+    usage.frontiers = astar.frontier_bytes();
+    usage.heuristic_tables = astar.heuristic_bytes();
+    usage.solution_caches = SCIPpricerTruffleHogGetSolutionCacheBytes(scip);
+    size_t outside_scip = usage.label_pools + usage.frontiers + usage.heuristic_tables + usage.solution_caches;
+
+    // Get the memory of the fractional vertices and edges. The arrays of fractional values of each edge are in the
+    // memory of SCIP.
+    {
+        size_t tables = 0;
+#if defined(USE_THREEVERTEX_CONFLICTS) || defined(USE_VERTEX_FOUREDGE_CONFLICTS)
+        for (const auto& fractional_vertices : SCIPprobdataGetFractionalVertices(probdata))
+        {
+            tables += hash_table_bytes(fractional_vertices);
+        }
+#endif
+        for (const auto& fractional_edges : SCIPprobdataGetFractionalEdges(probdata))
+        {
+            tables += hash_table_bytes(fractional_edges);
+        }
+        for (const auto& fractional_edges : SCIPprobdataGetFractionalMoveEdges(probdata))
+        {
+            tables += hash_table_bytes(fractional_edges);
+        }
+        for (const auto& positive_edges : SCIPprobdataGetPositiveMoveEdges(probdata))
+        {
+            tables += hash_table_bytes(positive_edges);
+        }
+        const auto& fractional_edges_vec = SCIPprobdataGetFractionalEdgesVec(probdata);
+        tables += hash_table_bytes(fractional_edges_vec);
+        usage.fractional_values = tables + fractional_edges_vec.size() * N * sizeof(SCIP_Real);
+        outside_scip += tables;
+    }
+
+    // Get the memory of the cuts. The edge-times of each cut are in the memory of SCIP.
+    {
+        const auto& cuts = SCIPprobdataGetTwoAgentRobustCuts(probdata);
+        size_t arrays = vector_bytes(cuts);
+        for (const auto& agent_cuts : SCIPprobdataGetAgentRobustCuts(probdata))
+        {
+            arrays += vector_bytes(agent_cuts);
+        }
+        size_t edge_times = 0;
+        for (const auto& cut : cuts)
+        {
+            edge_times += cut.size() * sizeof(EdgeTime);
+        }
+        usage.cuts = arrays + edge_times;
+        outside_scip += arrays;
+    }
+
+    // Get the memory of the columns, including the pool of purged columns. The paths are in the memory of SCIP.
+    {
+        const auto& vars = SCIPprobdataGetVars(probdata);
+        const auto& purged_vars = SCIPprobdataGetPurgedVars(probdata);
+        size_t arrays = vector_bytes(vars) + vector_bytes(purged_vars);
+        for (const auto& agent_vars : SCIPprobdataGetAgentVars(probdata))
+        {
+            arrays += vector_bytes(agent_vars);
+        }
+        const auto path_bytes = [](SCIP_VAR* var)
+        {
+            auto vardata = SCIPvarGetData(var);
+            return sizeof(Agent) + sizeof(Time) + sizeof(Int) + SCIPvardataGetPathLength(vardata) * sizeof(Edge);
+        };
+        size_t paths = 0;
+        for (const auto& [var, _] : vars)
+        {
+            paths += path_bytes(var);
+        }
+        for (const auto var : purged_vars)
+        {
+            paths += path_bytes(var);
+        }
+        usage.columns = arrays + paths;
+        outside_scip += arrays;
+    }
+
+    // Done.
+    usage.total = usage.scip + outside_scip;
+    return usage;
+}
+
+// Print the memory used by each part of the solver
+void print_memory_usage(
+    SCIP* scip    // SCIP
+)
+{
+    const auto usage = get_memory_usage(scip);
+    println("Memory             :  Used (MiB)");
+    println("  {:<17}: {:>11.1f}", "SCIP", usage.scip / BYTES_PER_MEGABYTE);
+    println("  {:<17}: {:>11.1f}", "label pools", usage.label_pools / BYTES_PER_MEGABYTE);
+    println("  {:<17}: {:>11.1f}", "frontiers", usage.frontiers / BYTES_PER_MEGABYTE);
+    println("  {:<17}: {:>11.1f}", "lower bounds", usage.heuristic_tables / BYTES_PER_MEGABYTE);
+    println("  {:<17}: {:>11.1f}", "solution caches", usage.solution_caches / BYTES_PER_MEGABYTE);
+    println("  {:<17}: {:>11.1f}", "fractional values", usage.fractional_values / BYTES_PER_MEGABYTE);
+    println("  {:<17}: {:>11.1f}", "robust cuts", usage.cuts / BYTES_PER_MEGABYTE);
+    println("  {:<17}: {:>11.1f}", "columns", usage.columns / BYTES_PER_MEGABYTE);
+    println("  {:<17}: {:>11.1f}", "total", usage.total / BYTES_PER_MEGABYTE);
+}
+
+// Free the caches of the pricer, one at a time, until the memory used is within the budget
+SCIP_RETCODE enforce_memory_budget(
+    SCIP* scip,                 // SCIP
+    const SCIP_Real budget      // Memory budget in megabytes
+)
+{
+    // Check.
+    debug_assert(scip);
+
+    // Exit if there is no budget or the memory used is within the budget.
+    if (budget >= SCIP_MEM_NOLIMIT)
+    {
+        return SCIP_OKAY;
+    }
+    const auto budget_bytes = static_cast<size_t>(budget * BYTES_PER_MEGABYTE);
+    const auto used = get_memory_usage(scip).total;
+    if (used <= budget_bytes)
+    {
+        return SCIP_OKAY;
+    }
+
+    // Get problem data.
+    auto probdata = SCIPgetProbData(scip);
+    debug_assert(probdata);
+    auto& astar = SCIPprobdataGetAStar(probdata);
+
+    // Free the blocks of the label pools not used by the latest search.
+    astar.shrink_label_pools();
+    auto remaining = get_memory_usage(scip).total;
+
+    // Free the time layers and the hash tables of the frontiers. The next run allocates them again.
+    if (remaining > budget_bytes)
+    {
+        astar.release_frontiers();
+        remaining = get_memory_usage(scip).total;
+    }
+
+    // Free the inputs to the previous runs of the pricer. Runs can no longer be skipped.
+    if (remaining > budget_bytes)
+    {
+        SCIPpricerTruffleHogClearSolutionCache(scip);
+        remaining = get_memory_usage(scip).total;
+    }
+
+    // Free the lower bounds shared with other instances and the lower bounds from the start nodes.
+    if (remaining > budget_bytes)
+    {
+        astar.clear_heuristic_cache();
+        remaining = get_memory_usage(scip).total;
+    }
+
+    // Print.
+    if (remaining < used)
+    {
+        println("Memory used {:.1f} MiB exceeds the budget of {:.1f} MiB. Freed caches to {:.1f} MiB",
+                used / BYTES_PER_MEGABYTE,
+                budget,
+                remaining / BYTES_PER_MEGABYTE);
+    }
+
+    // Done.
+    return SCIP_OKAY;
+}
@@ -0,0 +1,55 @@
+/*
+This file is part of BCP-MAPF.
+
+BCP-MAPF is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+BCP-MAPF is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+Author: Edward Lam <ed@ed-lam.com>
+*/
+
+#ifndef MAPF_MEMORY_H
+#define MAPF_MEMORY_H
+
+#include "Includes.h"
+
+// Estimate of the bytes of memory used by the solver
+struct MemoryUsage
+{
+    size_t scip;                 // Block memory of SCIP, which holds the columns, the cuts and the rows of fractional edges
+    size_t label_pools;          // Label pools of the pricer and its lower bounds
+    size_t frontiers;            // Dense time layers and hash tables of the frontiers of the low-level searches
+    size_t heuristic_tables;     // Lower bounds of the pricer
+    size_t solution_caches;      // Inputs to the previous run of the pricer for each agent
+    size_t fractional_values;    // Fractional vertices and edges of each agent and of each edge
+    size_t cuts;                 // Edge-times of the two-agent robust cuts
+    size_t columns;              // Paths of the columns
+    size_t total;                // Memory used by SCIP and the data outside of SCIP
+};
+
+// Estimate the memory used by the solver
+MemoryUsage get_memory_usage(
+    SCIP* scip    // SCIP
+);
+
+// Print the memory used by each part of the solver
+void print_memory_usage(
+    SCIP* scip    // SCIP
+);
+
+// Free the caches of the pricer, one at a time, until the memory used is within the budget
+SCIP_RETCODE enforce_memory_budget(
+    SCIP* scip,                 // SCIP
+    const SCIP_Real budget      // Memory budget in megabytes
+);
+
+#endif
@@ -21,10 +21,36 @@ Author: Edward Lam <ed@ed-lam.com>
 #include "Includes.h"
 #include "ProblemData.h"
 #include "VariableData.h"
-#include <sys/stat.h>
+#include "Clock.h"
+
+const char* status_name(
+    const SCIP_STATUS status    // Solution status
+)
+{
+    switch (status)
+    {
+        case SCIP_STATUS_OPTIMAL:
+            return "optimal";
+        case SCIP_STATUS_INFEASIBLE:
+            return "infeasible";
+        case SCIP_STATUS_TIMELIMIT:
+            return "time_limit";
+        case SCIP_STATUS_NODELIMIT:
+            return "node_limit";
+        case SCIP_STATUS_GAPLIMIT:
+            return "gap_limit";
+        case SCIP_STATUS_MEMLIMIT:
+            return "memory_limit";
+        case SCIP_STATUS_USERINTERRUPT:
+            return "interrupted";
+        default:
+            return "unknown";
+    }
+}
 
 SCIP_RETCODE write_best_solution(
-    SCIP* scip    // SCIP
+    SCIP* scip,                      // SCIP
+    const String& solution_path      // Path to solution file
 )
 {
     // Check.
@@ -38,16 +64,9 @@ SCIP_RETCODE write_best_solution(
     const auto& dummy_vars = SCIPprobdataGetDummyVars(probdata);
     const auto& agent_vars = SCIPprobdataGetAgentVars(probdata);
 
-    // Create output folder.
-    struct stat st{0};
-    if (stat(OUTPUTS_DIR, &st) == -1)
-        mkdir(OUTPUTS_DIR, 0700);
-
     // Open file.
-    const auto output_filename = fmt::format(OUTPUTS_DIR "/{}.sol",
-                                             SCIPgetProbName(scip));
-    auto f = fopen(output_filename.c_str(), "w");
-    release_assert(f, "Failed to create file to write solution");
+    auto f = fopen(solution_path.c_str(), "w");
+    release_assert(f, "Failed to create file {} to write solution", solution_path);
 
     // Get best solution.
     auto sol = SCIPgetBestSol(scip);
@@ -114,7 +133,7 @@ SCIP_RETCODE write_best_solution(
                            format_path(probdata, path_length, path));
 
                 // Move to next agent.
-                release_assert(!found, "Agent {} is using more than one path");
+                release_assert(!found, "Agent {} is using more than one path", a);
                 found = true;
                 break;
             }
@@ -129,3 +148,256 @@ SCIP_RETCODE write_best_solution(
     // Done.
     return SCIP_OKAY;
 }
+
+String json_string(
+    const String& str    // String
+)
+{
+    String output("\"");
+    for (const auto c : str)
+    {
+        if (c == '"' || c == '\\')
+        {
+            output.push_back('\\');
+            output.push_back(c);
+        }
+        else if (static_cast<unsigned char>(c) < 0x20)
+        {
+            output += fmt::format("\\u{:04x}", static_cast<unsigned char>(c));
+        }
+        else
+        {
+            output.push_back(c);
+        }
+    }
+    output.push_back('"');
+    return output;
+}
+
+String csv_string(
+    const String& str    // String
+)
+{
+    String output("\"");
+    for (const auto c : str)
+    {
+        if (c == '"')
+        {
+            output.push_back('"');
+        }
+        output.push_back(c);
+    }
+    output.push_back('"');
+    return output;
+}
+
+// Check if a report file holds comma-separated values
+static
+bool is_csv_report(
+    const String& report_path    // Path to report file
+)
+{
+    return report_path.size() >= 4 && report_path.compare(report_path.size() - 4, 4, ".csv") == 0;
+}
+
+void write_report_header(
+    const String& report_path    // Path to report file
+)
+{
+    // Only files of comma-separated values have a header.
+    if (!is_csv_report(report_path))
+    {
+        return;
+    }
+
+    // Write the header if the file is empty.
+    auto f = fopen(report_path.c_str(), "a");
+    release_assert(f, "Failed to open report file {}", report_path);
+    fseek(f, 0, SEEK_END);
+    if (ftell(f) == 0)
+    {
+        fputs("instance,agents,time_spacing,status,primal_bound,dual_bound,gap,nodes,lp_iterations,"
+              "pricing_rounds,columns,columns_priced,cuts,time,pricing_time,lp_time,separation_time,"
+              "heuristics_time,path_costs\n", f);
+    }
+    fclose(f);
+}
+
+SCIP_RETCODE write_report(
+    SCIP* scip,                       // SCIP
+    const String& report_path,        // Path to report file
+    const String& instance_file,      // Path to instance file
+    const int time_spacing            // Time-spacing parameter
+)
+{
+    // Check.
+    debug_assert(scip);
+
+    // Get problem data.
+    auto probdata = SCIPgetProbData(scip);
+    const auto N = SCIPprobdataGetN(probdata);
+    const auto& dummy_vars = SCIPprobdataGetDummyVars(probdata);
+    const auto& agent_vars = SCIPprobdataGetAgentVars(probdata);
+
+    // Get the pricing statistics.
+    Int nb_pricing_rounds = 0;
+    Int nb_columns_priced = 0;
+    SCIP_Real pricing_time = 0;
+    {
+        const auto npricers = SCIPgetNActivePricers(scip);
+        auto pricers = SCIPgetPricers(scip);
+        for (Int idx = 0; idx < npricers; ++idx)
+        {
+            auto pricer = pricers[idx];
+            nb_pricing_rounds += SCIPpricerGetNCalls(pricer);
+            nb_columns_priced += SCIPpricerGetNVarsFound(pricer);
+            pricing_time += SCIPpricerGetTime(pricer);
+        }
+    }
+
+    // Get the number of cuts of every separator and constraint handler with cuts.
+    Vector<Pair<String, SCIP_Longint>> cuts;
+    SCIP_Real separation_time = 0;
+    {
+        const auto nsepas = SCIPgetNSepas(scip);
+        auto sepas = SCIPgetSepas(scip);
+        for (Int idx = 0; idx < nsepas; ++idx)
+        {
+            auto sepa = sepas[idx];
+            separation_time += SCIPsepaGetTime(sepa);
+            if (const auto nb_cuts = SCIPsepaGetNCutsFound(sepa); nb_cuts > 0)
+            {
+                cuts.emplace_back(SCIPsepaGetName(sepa), nb_cuts);
+            }
+        }
+    }
+    {
+        const auto nconshdlrs = SCIPgetNConshdlrs(scip);
+        auto conshdlrs = SCIPgetConshdlrs(scip);
+        for (Int idx = 0; idx < nconshdlrs; ++idx)
+        {
+            auto conshdlr = conshdlrs[idx];
+            separation_time += SCIPconshdlrGetSepaTime(conshdlr);
+            if (const auto nb_cuts = SCIPconshdlrGetNCutsFound(conshdlr); nb_cuts > 0)
+            {
+                cuts.emplace_back(SCIPconshdlrGetName(conshdlr), nb_cuts);
+            }
+        }
+    }
+
+    // Get the time of the primal heuristics.
+    SCIP_Real heuristics_time = 0;
+    {
+        const auto nheurs = SCIPgetNHeurs(scip);
+        auto heurs = SCIPgetHeurs(scip);
+        for (Int idx = 0; idx < nheurs; ++idx)
+        {
+            heuristics_time += SCIPheurGetTime(heurs[idx]);
+        }
+    }
+
+    // Get the time of solving the LP.
+    const auto lp_time = SCIPclockGetTime(scip->stat->primallptime) +
+                         SCIPclockGetTime(scip->stat->duallptime) +
+                         SCIPclockGetTime(scip->stat->lexduallptime) +
+                         SCIPclockGetTime(scip->stat->barrierlptime) +
+                         SCIPclockGetTime(scip->stat->divinglptime);
+
+    // Get the cost of the path of every agent in the best solution.
+    Vector<SCIP_Real> path_costs;
+    if (auto sol = SCIPgetBestSol(scip); sol && SCIPgetSolOrigObj(scip, sol) < ARTIFICIAL_VAR_COST)
+    {
+        for (Agent a = 0; a < N; ++a)
+        {
+            debug_assert(dummy_vars[a]);
+            if (SCIPisPositive(scip, SCIPgetSolVal(scip, sol, dummy_vars[a])))
+            {
+                path_costs.clear();
+                break;
+            }
+            for (const auto& [var, _] : agent_vars[a])
+                if (SCIPisPositive(scip, SCIPgetSolVal(scip, sol, var)))
+                {
+                    path_costs.push_back(SCIPround(scip, SCIPvarGetObj(var)));
+                    break;
+                }
+        }
+    }
+
+    // Write the header of a new file and open it.
+    write_report_header(report_path);
+    auto f = fopen(report_path.c_str(), "a");
+    release_assert(f, "Failed to open report file {}", report_path);
+
+    // Write a line of comma-separated values if the file has the extension .csv and a JSON object otherwise.
+    String record;
+    const auto status = SCIPgetStatus(scip);
+    if (is_csv_report(report_path))
+    {
+        String cuts_str;
+        for (const auto& [name, nb_cuts] : cuts)
+        {
+            cuts_str += fmt::format("{}{}:{}", cuts_str.empty() ? "" : ";", name, nb_cuts);
+        }
+        record = fmt::format("{},{},{},{},{},{},{},{},{},{},{},{},{},{:.3f},{:.3f},{:.3f},{:.3f},{:.3f},{}\n",
+                              csv_string(instance_file),
+                              N,
+                              time_spacing,
+                              csv_string(status_name(status)),
+                              SCIPgetPrimalbound(scip),
+                              SCIPgetDualbound(scip),
+                              SCIPgetGap(scip),
+                              SCIPgetNNodes(scip),
+                              SCIPgetNLPIterations(scip),
+                              nb_pricing_rounds,
+                              SCIPprobdataGetVars(probdata).size(),
+                              nb_columns_priced,
+                              csv_string(cuts_str),
+                              SCIPgetSolvingTime(scip),
+                              pricing_time,
+                              lp_time,
+                              separation_time,
+                              heuristics_time,
+                              fmt::join(path_costs, ";"));
+    }
+    else
+    {
+        String cuts_str;
+        for (const auto& [name, nb_cuts] : cuts)
+        {
+            cuts_str += fmt::format("{}{}: {}", cuts_str.empty() ? "" : ", ", json_string(name), nb_cuts);
+        }
+        record = fmt::format("{{\"instance\": {}, \"agents\": {}, \"time_spacing\": {}, \"status\": {}, "
+                             "\"primal_bound\": {}, \"dual_bound\": {}, \"gap\": {}, \"nodes\": {}, "
+                             "\"lp_iterations\": {}, \"pricing_rounds\": {}, \"columns\": {}, "
+                             "\"columns_priced\": {}, \"cuts\": {{{}}}, \"time\": {:.3f}, "
+                             "\"pricing_time\": {:.3f}, \"lp_time\": {:.3f}, \"separation_time\": {:.3f}, "
+                             "\"heuristics_time\": {:.3f}, \"path_costs\": [{}]}}\n",
+                             json_string(instance_file),
+                             N,
+                             time_spacing,
+                             json_string(status_name(status)),
+                             SCIPgetPrimalbound(scip),
+                             SCIPgetDualbound(scip),
+                             SCIPgetGap(scip),
+                             SCIPgetNNodes(scip),
+                             SCIPgetNLPIterations(scip),
+                             nb_pricing_rounds,
+                             SCIPprobdataGetVars(probdata).size(),
+                             nb_columns_priced,
+                             cuts_str,
+                             SCIPgetSolvingTime(scip),
+                             pricing_time,
+                             lp_time,
+                             separation_time,
+                             heuristics_time,
+                             fmt::join(path_costs, ", "));
+    }
+
+    // Write and close file.
+    fputs(record.c_str(), f);
+    fclose(f);
+
+    // Done.
+    return SCIP_OKAY;
+}
@@ -22,9 +22,38 @@ Author: Edward Lam <ed@ed-lam.com>
 
 #include "Includes.h"
 
+// Get the name of a solution status
+const char* status_name(
+    const SCIP_STATUS status    // Solution status
+);
+
+// Escape a string for JSON
+String json_string(
+    const String& str    // String
+);
+
+// Quote a string for CSV
+String csv_string(
+    const String& str    // String
+);
+
 // Write best solution to file
 SCIP_RETCODE write_best_solution(
-    SCIP* scip    // SCIP
+    SCIP* scip,                      // SCIP
+    const String& solution_path      // Path to solution file
+);
+
+// Write the header of a report file of comma-separated values if the file is empty
+void write_report_header(
+    const String& report_path    // Path to report file
+);
+
+// Append a record of the statistics of the run to file
+SCIP_RETCODE write_report(
+    SCIP* scip,                       // SCIP
+    const String& report_path,        // Path to report file
+    const String& instance_file,      // Path to instance file
+    const int time_spacing            // Time-spacing parameter
 );
 
 #endif
@@ -40,6 +40,7 @@ Author: Edward Lam <ed@ed-lam.com>
 
 #include "trufflehog/Instance.h"
 #include "trufflehog/AStar.h"
+#include "Memory.h"
 
 // Pricer properties
 #define PRICER_NAME     "trufflehog"
@@ -55,13 +56,42 @@ Author: Edward Lam <ed@ed-lam.com>
 #endif
 #define STALLED_ABSOLUTE_CHANGE (-1)
 
+#define DEFAULT_MEMORY_BUDGET (SCIP_MEM_NOLIMIT)    // Megabytes of memory used before freeing the caches
+#define MEMORY_CHECK_INTERVAL (1.0)                 // Seconds between checks of the memory used
+#define DEFAULT_FRONTIER_MEMORY (64.0)              // Megabytes of memory of the dense layers of the frontiers
+#define DEFAULT_LABEL_POOL_BLOCK_SIZE (LABEL_POOL_BLOCK_SIZE / (1024 * 1024))    // Megabytes of a block of labels
+
 struct PricingOrder
 {
     Agent a;
     bool must_price;
+    SCIP_Real score;
     SCIP_VAR* new_var;
 };
 
+// Statistics of pricing an agent, used to order the agents
+struct AgentPricingStatistics
+{
+    SCIP_Real avg_time;                                 // Smoothed run time of the low-level solver
+    SCIP_Real success_rate;                             // Smoothed rate of finding a column
+    SCIP_Real avg_reduced_cost;                         // Smoothed magnitude of the reduced cost of new columns
+    SCIP_Real total_time;                               // Total run time of the low-level solver
+    Int nb_calls;                                       // Number of runs of the low-level solver
+    Int nb_columns;                                     // Number of columns found
+    Int nb_skipped_bound;                               // Number of runs skipped by the lower bound
+    Int nb_skipped_cache;                               // Number of runs skipped by the solution cache
+};
+
+// Branching decisions of an agent at the current node
+struct AgentBranchingDecisions
+{
+    Vector<NodeTime> waypoints;                         // Node-times the agent must visit, sorted by time
+    Vector<NodeTime> forbidden_vertices;                // Node-times the agent must not visit
+    Time earliest_goal_time;                            // Earliest time the agent can finish
+    Time latest_goal_time;                              // Latest time the agent can finish
+    HashTable<Node, Time> latest_visit_time;            // Latest time the agent can visit a node blocked by another agent
+};
+
 // Pricer data
 struct SCIP_PricerData
 {
@@ -71,16 +101,27 @@ struct SCIP_PricerData
     Agent N;                                            // Number of agents
 
     SCIP_Real* agent_part_dual;                         // Dual variable values of agent set partition constraints
-    SCIP_Real* price_priority;                          // Pricing priority of each agent
+    AgentPricingStatistics* pricing_stats;              // Pricing statistics of each agent
     bool* agent_priced;                                 // Indicates if an agent is priced in the current round
     PricingOrder* order;                                // Order of agents to price
 
 #ifdef USE_ASTAR_SOLUTION_CACHING
     Vector<AStar::Data> previous_data;                  // Inputs to the previous run for an agent
+    Vector<SCIP_Real> previous_cost;                    // Cost of the optimal path of the previous run for an agent
+    Vector<bool> previous_is_farkas;                    // Indicates if the previous run for an agent was Farkas pricing
+    bool cache_solutions;                               // Indicates if the inputs to the runs are stored
 #endif
+#ifdef USE_RESERVATION_TABLE
+    HashTable<SCIP_VAR*, Time> reserved_vars;           // Paths in the reservation table and the end of their reservation
+#endif
+    SCIP_Real next_memory_check_time;                   // Solving time of the next check of the memory budget
 
     SCIP_Longint last_solved_node;                      // Node number of the last node pricing
     SCIP_Real last_solved_lp_obj[STALLED_NB_ROUNDS];    // LP objective in the last few rounds of pricing
+
+    SCIP_Longint branching_decisions_node;              // Node number of the stored branching decisions
+    Int branching_decisions_nb_conss;                   // Number of active branching constraints at the node
+    Vector<AgentBranchingDecisions> branching_decisions;// Branching decisions of each agent at the node
 };
 
 // Initialize pricer (called after the problem was transformed)
@@ -103,6 +144,9 @@ SCIP_DECL_PRICERINIT(pricerTruffleHogInit)
     new (pricerdata) SCIP_PricerData;
     pricerdata->N = SCIPprobdataGetN(probdata);
     pricerdata->last_solved_node = -1;
+    pricerdata->branching_decisions_node = -1;
+    pricerdata->branching_decisions_nb_conss = 0;
+    pricerdata->branching_decisions.resize(pricerdata->N);
 
     // Find constraint handler for branching decisions.
     pricerdata->vertex_branching_conshdlr = SCIPfindConshdlr(scip, "vertex_branching");
@@ -119,9 +163,9 @@ SCIP_DECL_PRICERINIT(pricerTruffleHogInit)
     SCIP_CALL(SCIPallocBlockMemoryArray(scip, &pricerdata->agent_part_dual, pricerdata->N));
     // Overwritten in each run. No need for initialisation.
 
-    // Create array for agent priority in pricing.
-    SCIP_CALL(SCIPallocBlockMemoryArray(scip, &pricerdata->price_priority, pricerdata->N));
-    memset(pricerdata->price_priority, 0, sizeof(SCIP_Real) * pricerdata->N);
+    // Create array for pricing statistics.
+    SCIP_CALL(SCIPallocBlockMemoryArray(scip, &pricerdata->pricing_stats, pricerdata->N));
+    memset(pricerdata->pricing_stats, 0, sizeof(AgentPricingStatistics) * pricerdata->N);
 
     // Create array for priced indicator.
     SCIP_CALL(SCIPallocBlockMemoryArray(scip, &pricerdata->agent_priced, pricerdata->N));
@@ -134,7 +178,29 @@ SCIP_DECL_PRICERINIT(pricerTruffleHogInit)
     // Create space to store the penalties from the previous failed iteration.
 #ifdef USE_ASTAR_SOLUTION_CACHING
     pricerdata->previous_data.resize(pricerdata->N);
+    pricerdata->previous_cost.resize(pricerdata->N, -std::numeric_limits<SCIP_Real>::infinity());
+    pricerdata->previous_is_farkas.resize(pricerdata->N);
+    pricerdata->cache_solutions = true;
 #endif
+    pricerdata->next_memory_check_time = 0.0;
+
+    // Set the memory shared by the dense layers of the frontiers of the low-level searches.
+    {
+        SCIP_Real frontier_memory;
+        SCIP_CALL(SCIPgetRealParam(scip, "pricers/" PRICER_NAME "/frontiermemory", &frontier_memory));
+        FrontierMemory::set_limit(static_cast<size_t>(frontier_memory * 1024.0 * 1024.0));
+    }
+
+    // Set the size of the blocks of the label pool of the low-level searches.
+    {
+        int label_pool_block_size;
+        SCIP_CALL(SCIPgetIntParam(scip, "pricers/" PRICER_NAME "/labelpoolblocksize", &label_pool_block_size));
+        if (label_pool_block_size != DEFAULT_LABEL_POOL_BLOCK_SIZE)
+        {
+            auto& astar = SCIPprobdataGetAStar(probdata);
+            astar.set_label_pool_block_size(label_pool_block_size * 1024 * 1024);
+        }
+    }
 
     // Set pointer to pricer data.
     SCIPpricerSetData(pricer, pricerdata);
@@ -159,7 +225,7 @@ SCIP_DECL_PRICERFREE(pricerTruffleHogFree)
 
     // Deallocate.
     SCIPfreeBlockMemoryArray(scip, &pricerdata->agent_part_dual, pricerdata->N);
-    SCIPfreeBlockMemoryArray(scip, &pricerdata->price_priority, pricerdata->N);
+    SCIPfreeBlockMemoryArray(scip, &pricerdata->pricing_stats, pricerdata->N);
     SCIPfreeBlockMemoryArray(scip, &pricerdata->agent_priced, pricerdata->N);
     SCIPfreeBlockMemoryArray(scip, &pricerdata->order, pricerdata->N);
     pricerdata->~SCIP_PricerData();
@@ -169,6 +235,139 @@ SCIP_DECL_PRICERFREE(pricerTruffleHogFree)
     return SCIP_OKAY;
 }
 
+// Update the statistics of an agent after running the low-level solver
+static inline
+void update_pricing_statistics(
+    AgentPricingStatistics& stats,    // Statistics of the agent
+    const SCIP_Real time,             // Run time of the low-level solver
+    const SCIP_Real reduced_cost      // Reduced cost of the new column, or zero if no column is found
+)
+{
+    const bool success = reduced_cost < 0;
+    const SCIP_Real alpha = stats.nb_calls == 0 ? 1.0 : PRICING_STATISTICS_SMOOTHING;
+    stats.avg_time = (1.0 - alpha) * stats.avg_time + alpha * time;
+    stats.success_rate = (1.0 - alpha) * stats.success_rate + alpha * success;
+    if (success)
+    {
+        const SCIP_Real beta = stats.nb_columns == 0 ? 1.0 : PRICING_STATISTICS_SMOOTHING;
+        stats.avg_reduced_cost = (1.0 - beta) * stats.avg_reduced_cost + beta * -reduced_cost;
+        stats.nb_columns++;
+    }
+    stats.total_time += time;
+    stats.nb_calls++;
+}
+
+// Expected magnitude of negative reduced cost found per second of pricing an agent
+static inline
+SCIP_Real pricing_score(
+    const AgentPricingStatistics& stats    // Statistics of the agent
+)
+{
+    // Price agents without history first.
+    if (stats.nb_calls == 0)
+    {
+        return std::numeric_limits<SCIP_Real>::infinity();
+    }
+    return stats.success_rate * stats.avg_reduced_cost / std::max(stats.avg_time, PRICING_MIN_TIME);
+}
+
+#ifdef USE_RESERVATION_TABLE
+// Reserve or unreserve the vertices of a path between two times, waiting at the goal after the path finishes
+template<bool reserve>
+static inline
+void update_path_reservation(
+    ReservationTable& restab,    // Reservation table
+    const Time path_length,      // Path length
+    const Edge* const path,      // Path
+    const Time begin,            // First time to update
+    const Time end               // One past the last time to update
+)
+{
+    debug_assert(path_length >= 1);
+    Time t = begin;
+    for (; t < std::min(path_length, end); ++t)
+    {
+        if constexpr (reserve)
+        {
+            restab.reserve(NodeTime{path[t].n, t});
+        }
+        else
+        {
+            restab.unreserve(NodeTime{path[t].n, t});
+        }
+    }
+    const auto goal = path[path_length - 1].n;
+    for (; t < end; ++t)
+    {
+        if constexpr (reserve)
+        {
+            restab.reserve(NodeTime{goal, t});
+        }
+        else
+        {
+            restab.unreserve(NodeTime{goal, t});
+        }
+    }
+}
+
+// Update the reservation table to contain the paths with value 1, applying only the changes since the last round
+static
+void update_reservation_table(
+    SCIP* scip,                    // SCIP
+    SCIP_PROBDATA* probdata,       // Problem data
+    SCIP_PricerData* pricerdata,   // Pricer data
+    ReservationTable& restab,      // Reservation table
+    const Time makespan            // Time up to which paths wait at their goal
+)
+{
+    auto& reserved_vars = pricerdata->reserved_vars;
+
+    // Unreserve paths that no longer have value 1 and re-pad the remaining paths to the new makespan.
+    for (auto it = reserved_vars.begin(); it != reserved_vars.end();)
+    {
+        auto& [var, reserved_end] = *it;
+        auto vardata = SCIPvarGetData(var);
+        const auto path_length = SCIPvardataGetPathLength(vardata);
+        const auto path = SCIPvardataGetPath(vardata);
+        if (SCIPgetSolVal(scip, nullptr, var) < 0.5)
+        {
+            update_path_reservation<false>(restab, path_length, path, 0, reserved_end);
+            it = reserved_vars.erase(it);
+            continue;
+        }
+
+        const auto end = std::max(path_length, makespan);
+        if (end > reserved_end)
+        {
+            update_path_reservation<true>(restab, path_length, path, reserved_end, end);
+        }
+        else if (end < reserved_end)
+        {
+            update_path_reservation<false>(restab, path_length, path, end, reserved_end);
+        }
+        reserved_end = end;
+        ++it;
+    }
+
+    // Reserve paths that newly have value 1.
+    const auto& vars = SCIPprobdataGetVars(probdata);
+    for (const auto& [var, var_val] : vars)
+    {
+        debug_assert(var);
+        debug_assert(var_val == SCIPgetSolVal(scip, nullptr, var));
+        if (var_val >= 0.5 && reserved_vars.find(var) == reserved_vars.end())
+        {
+            auto vardata = SCIPvarGetData(var);
+            const auto path_length = SCIPvardataGetPathLength(vardata);
+            const auto path = SCIPvardataGetPath(vardata);
+            const auto end = std::max(path_length, makespan);
+            update_path_reservation<true>(restab, path_length, path, 0, end);
+            reserved_vars[var] = end;
+        }
+    }
+}
+#endif
+
 enum class MasterProblemStatus
 {
     Infeasible = 0,
@@ -220,7 +419,7 @@ MasterProblemStatus calculate_agents_order(
         }
 
         // Store.
-        order[a] = {a, must_price_agent, nullptr};
+        order[a] = {a, must_price_agent, pricing_score(pricerdata->pricing_stats[a]), nullptr};
     }
 
     // Price all agents if the master problem solution is integral.
@@ -232,17 +431,15 @@ MasterProblemStatus calculate_agents_order(
         }
     }
 
-    // Sort.
-    {
-        auto price_priority = pricerdata->price_priority;
-        std::sort(order,
-                  order + N,
-                  [price_priority](const PricingOrder& a, const PricingOrder& b)
-                  {
-                      return (a.must_price >  b.must_price) ||
-                             (a.must_price == b.must_price && price_priority[a.a] > price_priority[b.a]);
-                  });
-    }
+    // Sort by expected reduced cost per unit of time.
+    std::sort(order,
+              order + N,
+              [](const PricingOrder& a, const PricingOrder& b)
+              {
+                  return (a.must_price >  b.must_price) ||
+                         (a.must_price == b.must_price && a.score >  b.score) ||
+                         (a.must_price == b.must_price && a.score == b.score && a.a < b.a);
+              });
 
     // Reset.
     memset(pricerdata->agent_priced, 0, sizeof(bool) * pricerdata->N);
@@ -251,6 +448,134 @@ MasterProblemStatus calculate_agents_order(
     return master_lp_status;
 }
 
+// Collect the active branching decisions of each agent once per node
+static
+void update_branching_decisions(
+    SCIP* scip,                    // SCIP
+    SCIP_PricerData* pricerdata,   // Pricer data
+    const Map& map                 // Map
+)
+{
+    // Get constraints for branching decisions.
+    const auto n_vertex_branching_conss = SCIPconshdlrGetNConss(pricerdata->vertex_branching_conshdlr);
+    auto vertex_branching_conss = SCIPconshdlrGetConss(pricerdata->vertex_branching_conshdlr);
+    debug_assert(n_vertex_branching_conss == 0 || vertex_branching_conss);
+    const auto n_length_branching_conss = SCIPconshdlrGetNConss(pricerdata->length_branching_conshdlr);
+    auto length_branching_conss = SCIPconshdlrGetConss(pricerdata->length_branching_conshdlr);
+    debug_assert(n_length_branching_conss == 0 || length_branching_conss);
+
+    // Skip if the decisions of this node are already stored. The active constraints only change between nodes.
+    const auto current_node = SCIPnodeGetNumber(SCIPgetCurrentNode(scip));
+    const auto nb_conss = SCIPconshdlrGetNActiveConss(pricerdata->vertex_branching_conshdlr) +
+                          SCIPconshdlrGetNActiveConss(pricerdata->length_branching_conshdlr);
+    if (pricerdata->branching_decisions_node == current_node && pricerdata->branching_decisions_nb_conss == nb_conss)
+    {
+        return;
+    }
+    pricerdata->branching_decisions_node = current_node;
+    pricerdata->branching_decisions_nb_conss = nb_conss;
+
+    // Clear the decisions of the previous node.
+    auto& branching_decisions = pricerdata->branching_decisions;
+    for (auto& decisions : branching_decisions)
+    {
+        decisions.waypoints.clear();
+        decisions.forbidden_vertices.clear();
+        decisions.earliest_goal_time = 0;
+        decisions.latest_goal_time = std::numeric_limits<Time>::max();
+        decisions.latest_visit_time.clear();
+    }
+
+    // Store the vertex branching decisions.
+    for (Int c = 0; c < n_vertex_branching_conss; ++c)
+    {
+        // Get the constraint.
+        auto cons = vertex_branching_conss[c];
+        debug_assert(cons);
+
+        // Ignore constraints that are not active since these are not on the current
+        // active path of the search tree.
+        if (!SCIPconsIsActive(cons))
+            continue;
+
+        // Forbid the vertex or store a waypoint to enforce use of the vertex.
+        const auto branch_a = SCIPgetVertexBranchingAgent(cons);
+        const auto dir = SCIPgetVertexBranchingDirection(cons);
+        const auto nt = SCIPgetVertexBranchingNodeTime(cons);
+        if (dir == VertexBranchDirection::Forbid)
+        {
+            branching_decisions[branch_a].forbidden_vertices.push_back(nt);
+        }
+        else
+        {
+            debug_assert(dir == VertexBranchDirection::Use);
+            for (Agent a = 0; a < pricerdata->N; ++a)
+                if (a == branch_a)
+                {
+                    branching_decisions[a].waypoints.push_back(nt);
+                }
+                else
+                {
+                    branching_decisions[a].forbidden_vertices.push_back(nt);
+                }
+        }
+    }
+
+    // Sort waypoints by time.
+    for (auto& decisions : branching_decisions)
+    {
+        auto& waypoints = decisions.waypoints;
+        std::sort(waypoints.begin(), waypoints.end(), [](const auto& a, const auto& b)
+        {
+            return a.t < b.t;
+        });
+#ifdef DEBUG
+        for (size_t idx = 1; idx < waypoints.size(); ++idx)
+        {
+            debug_assert(waypoints[idx - 1].t < waypoints[idx].t);
+        }
+#endif
+    }
+
+    // Store the length branching decisions.
+    for (Int c = 0; c < n_length_branching_conss; ++c)
+    {
+        // Get the constraint.
+        auto cons = length_branching_conss[c];
+        debug_assert(cons);
+
+        // Ignore constraints that are not active since these are not on the current active path of the search tree.
+        if (!SCIPconsIsActive(cons))
+            continue;
+
+        // Limit the finish time of the same agent. Disable crossing for different agents.
+        const auto branch_a = SCIPgetLengthBranchingAgent(cons);
+        const auto dir = SCIPgetLengthBranchingDirection(cons);
+        const auto nt = SCIPgetLengthBranchingNodeTime(cons);
+        if (dir == LengthBranchDirection::LEq)
+        {
+            branching_decisions[branch_a].latest_goal_time =
+                std::min(branching_decisions[branch_a].latest_goal_time, nt.t);
+
+            // Block crossing the node at time t and later. Only the nodes that differ from the map are stored.
+            for (Agent a = 0; a < pricerdata->N; ++a)
+                if (a != branch_a)
+                {
+                    auto [it, success] = branching_decisions[a].latest_visit_time.try_emplace(
+                        nt.n,
+                        map.latest_visit_time()[nt.n]
+                    );
+                    it->second = std::min(it->second, nt.t - 1);
+                }
+        }
+        else
+        {
+            branching_decisions[branch_a].earliest_goal_time =
+                std::max(branching_decisions[branch_a].earliest_goal_time, nt.t);
+        }
+    }
+}
+
 static
 SCIP_RETCODE run_trufflehog_pricer(
     SCIP* scip,               // SCIP
@@ -271,6 +596,9 @@ SCIP_RETCODE run_trufflehog_pricer(
     auto pricerdata = SCIPpricerGetData(pricer);
     debug_assert(pricerdata);
 
+    // Trace.
+    TRACE_SCOPE("pricing", "node", SCIPnodeGetNumber(SCIPgetCurrentNode(scip)));
+
     // Print.
     if constexpr (!is_farkas)
     {
@@ -293,16 +621,28 @@ SCIP_RETCODE run_trufflehog_pricer(
     const auto& map = SCIPprobdataGetMap(probdata);
     const auto& agents = SCIPprobdataGetAgentsData(probdata);
 
+    // Free the caches if the memory used is over the budget.
+    if (const auto time = SCIPgetSolvingTime(scip); time >= pricerdata->next_memory_check_time)
+    {
+        SCIP_Real memory_budget;
+        SCIP_CALL(SCIPgetRealParam(scip, "pricers/" PRICER_NAME "/memorybudget", &memory_budget));
+        SCIP_CALL(enforce_memory_budget(scip, memory_budget));
+        pricerdata->next_memory_check_time = time + MEMORY_CHECK_INTERVAL;
+    }
+
     // Update variable values.
     update_variable_values(scip);
 
+    // Age the variables and purge the variables unused for many pricing rounds. The reduced costs are only valid in
+    // the feasible master problem.
+    if constexpr (!is_farkas)
+    {
+        SCIP_CALL(SCIPprobdataPurgeVars(scip, probdata));
+    }
+
     // Create order of agents to solve.
     auto order = pricerdata->order;
     const auto master_lp_status = calculate_agents_order(scip, probdata, pricerdata);
-    for (Agent a = 0; a < N; ++a)
-    {
-        pricerdata->price_priority[a] /= PRICE_PRIORITY_DECAY_FACTOR;
-    }
 
     // Early branching if LP is stalled.
     if constexpr (!is_farkas)
@@ -382,13 +722,8 @@ SCIP_RETCODE run_trufflehog_pricer(
     const auto& path_length_nogoods = SCIPprobdataGetPathLengthNogoods(probdata);
 #endif
 
-    // Get constraints for branching decisions.
-    const auto n_vertex_branching_conss = SCIPconshdlrGetNConss(pricerdata->vertex_branching_conshdlr);
-    auto vertex_branching_conss = SCIPconshdlrGetConss(pricerdata->vertex_branching_conshdlr);
-    debug_assert(n_vertex_branching_conss == 0 || vertex_branching_conss);
-    const auto n_length_branching_conss = SCIPconshdlrGetNConss(pricerdata->length_branching_conshdlr);
-    auto length_branching_conss = SCIPconshdlrGetConss(pricerdata->length_branching_conshdlr);
-    debug_assert(n_length_branching_conss == 0 || length_branching_conss);
+    // Get branching decisions.
+    update_branching_decisions(scip, pricerdata, map);
 
     // Get the low-level solver.
     auto& astar = SCIPprobdataGetAStar(probdata);
@@ -531,35 +866,11 @@ SCIP_RETCODE run_trufflehog_pricer(
     // Set up reservation table. Reserve vertices of paths with value 1.
 #ifdef USE_RESERVATION_TABLE
     auto& restab = astar.reservation_table();
-    restab.clear_reservations();
-    for (const auto& [var, var_val] : vars)
-    {
-        debug_assert(var);
-        debug_assert(var_val == SCIPgetSolVal(scip, nullptr, var));
-        if (var_val >= 0.5)
-        {
-            // Get the path.
-            auto vardata = SCIPvarGetData(var);
-            const auto path_length = SCIPvardataGetPathLength(vardata);
-            const auto path = SCIPvardataGetPath(vardata);
-
-            // Update reservation table.
-            Node n;
-            Time t = 0;
-            for (; t < path_length; ++t)
-            {
-                n = path[t].n;
-                restab.reserve(NodeTime{n, t});
-            }
-            for (; t < makespan; ++t)
-            {
-                restab.reserve(NodeTime{n, t});
-            }
-        }
-    }
+    update_reservation_table(scip, probdata, pricerdata, restab, makespan);
 #endif
 
     // Make edge penalties for all agents.
+    TRACE_NAMED_SCOPE(global_penalties_trace, "global_penalties");
     EdgePenalties global_edge_penalties;
 
     // Input dual values for vertex conflicts.
@@ -617,6 +928,12 @@ SCIP_RETCODE run_trufflehog_pricer(
         }
     }
 
+    // Create the SIPP intervals common to all agents.
+#ifdef USE_SIPP
+    astar.set_shared_edge_penalties(global_edge_penalties);
+#endif
+    TRACE_END(global_penalties_trace);
+
     // Price each agent.
     const auto ts = SCIPprobdataGetTimeSpacing(probdata);
     // println("Time spacing: {}", ts);
@@ -637,9 +954,14 @@ SCIP_RETCODE run_trufflehog_pricer(
 
         // Set up start and end points.
         const auto a = order[order_idx].a;
+        TRACE_SCOPE("price_agent", "agent", a);
+        TRACE_NAMED_SCOPE(agent_penalties_trace, "agent_penalties");
         start = agents[a].start;
         goal = agents[a].goal;
         edge_penalties = global_edge_penalties;
+#ifdef USE_SIPP
+        edge_penalties.track_modified();
+#endif
 
         // Input the agent partition dual.
         {
@@ -1008,130 +1330,79 @@ SCIP_RETCODE run_trufflehog_pricer(
 #endif
 
         // Modify edge costs for vertex branching decisions.
-        waypoints.clear();
-        for (Int c = 0; c < n_vertex_branching_conss; ++c)
+        const auto& branching_decisions = pricerdata->branching_decisions[a];
+        for (const auto nt : branching_decisions.forbidden_vertices)
         {
-            // Get the constraint.
-            auto cons = vertex_branching_conss[c];
-            debug_assert(cons);
-
-            // Ignore constraints that are not active since these are not on the current
-            // active path of the search tree.
-            if (!SCIPconsIsActive(cons))
-                continue;
-
-            // Enforce the decision.
-            const auto branch_a = SCIPgetVertexBranchingAgent(cons);
-            const auto dir = SCIPgetVertexBranchingDirection(cons);
-            const auto nt = SCIPgetVertexBranchingNodeTime(cons);
-            if ((a == branch_a && dir == VertexBranchDirection::Forbid) ||
-                (a != branch_a && dir == VertexBranchDirection::Use))
+            // Don't use the vertex.
+            const auto prev_time = nt.t - 1;
             {
-                // Don't use the vertex.
-                const auto prev_time = nt.t - 1;
-                {
-                    const auto n = map.get_south(nt.n);
-                    auto& penalties = edge_penalties.get_edge_penalties(n, prev_time);
-                    penalties.north = std::numeric_limits<Cost>::infinity();
-                }
-                {
-                    const auto n = map.get_north(nt.n);
-                    auto& penalties = edge_penalties.get_edge_penalties(n, prev_time);
-                    penalties.south = std::numeric_limits<Cost>::infinity();
-                }
-                {
-                    const auto n = map.get_west(nt.n);
-                    auto& penalties = edge_penalties.get_edge_penalties(n, prev_time);
-                    penalties.east = std::numeric_limits<Cost>::infinity();
-                }
-                {
-                    const auto n = map.get_east(nt.n);
-                    auto& penalties = edge_penalties.get_edge_penalties(n, prev_time);
-                    penalties.west = std::numeric_limits<Cost>::infinity();
-                }
-                {
-                    const auto n = map.get_wait(nt.n);
-                    auto& penalties = edge_penalties.get_edge_penalties(n, prev_time);
-                    penalties.wait = std::numeric_limits<Cost>::infinity();
-                }
+                const auto n = map.get_south(nt.n);
+                auto& penalties = edge_penalties.get_edge_penalties(n, prev_time);
+                penalties.north = std::numeric_limits<Cost>::infinity();
             }
-            else if (a == branch_a)
             {
-                debug_assert(dir == VertexBranchDirection::Use);
-
-                // Store a waypoint to enforce use of the vertex.
-                waypoints.push_back(nt);
+                const auto n = map.get_north(nt.n);
+                auto& penalties = edge_penalties.get_edge_penalties(n, prev_time);
+                penalties.south = std::numeric_limits<Cost>::infinity();
             }
-        }
-
-        // Sort waypoints by time.
-        std::sort(waypoints.begin(), waypoints.end(), [](const auto& a, const auto& b)
-        {
-            return a.t < b.t;
-        });
-#ifdef DEBUG
-        for (size_t idx = 1; idx < waypoints.size(); ++idx)
-        {
-            debug_assert(waypoints[idx - 1].t < waypoints[idx].t);
-        }
-#endif
-
-        // Modify edge costs for length branching decisions.
-        debug_assert(astar.max_path_length() >= 1);
-        earliest_goal_time = 0;
-        latest_goal_time = astar.max_path_length() - 1;
-        latest_visit_time = map.latest_visit_time();
-        for (Int c = 0; c < n_length_branching_conss; ++c)
-        {
-            // Get the constraint.
-            auto cons = length_branching_conss[c];
-            debug_assert(cons);
-
-            // Ignore constraints that are not active since these are not on the current active path of the search tree.
-            if (!SCIPconsIsActive(cons))
-                continue;
-
-            // Enforce the decision if the same agent. Disable crossing if different agent.
-            const auto branch_a = SCIPgetLengthBranchingAgent(cons);
-            const auto dir = SCIPgetLengthBranchingDirection(cons);
-            const auto nt = SCIPgetLengthBranchingNodeTime(cons);
-            if (a == branch_a)
             {
-                if (dir == LengthBranchDirection::LEq)
-                {
-                    latest_goal_time = std::min(latest_goal_time, nt.t);
-                }
-                else
-                {
-                    earliest_goal_time = std::max(earliest_goal_time, nt.t);
-                }
+                const auto n = map.get_west(nt.n);
+                auto& penalties = edge_penalties.get_edge_penalties(n, prev_time);
+                penalties.east = std::numeric_limits<Cost>::infinity();
+            }
+            {
+                const auto n = map.get_east(nt.n);
+                auto& penalties = edge_penalties.get_edge_penalties(n, prev_time);
+                penalties.west = std::numeric_limits<Cost>::infinity();
             }
-            else if (dir == LengthBranchDirection::LEq)
             {
-                // Block crossing the node at time t and later.
-                latest_visit_time[nt.n] = std::min(latest_visit_time[nt.n], nt.t - 1);
+                const auto n = map.get_wait(nt.n);
+                auto& penalties = edge_penalties.get_edge_penalties(n, prev_time);
+                penalties.wait = std::numeric_limits<Cost>::infinity();
             }
         }
+        waypoints = branching_decisions.waypoints;
+
+        // Modify edge costs for length branching decisions.
+        debug_assert(astar.max_path_length() >= 1);
+        earliest_goal_time = branching_decisions.earliest_goal_time;
+        latest_goal_time = std::min<Time>(branching_decisions.latest_goal_time, astar.max_path_length() - 1);
+        latest_visit_time = branching_decisions.latest_visit_time;
         debug_assert(waypoints.empty() || latest_goal_time >= waypoints.back().t);
 
         // Preprocess input data.
         astar.preprocess_input();
+        TRACE_END(agent_penalties_trace);
+
+        // Skip the agent if every path has non-negative reduced cost.
+        auto& stats = pricerdata->pricing_stats[a];
+        if (SCIPisSumGE(scip, astar.lower_bound<is_farkas>(), 0.0))
+        {
+            stats.nb_skipped_bound++;
+            agent_priced[a] = true;
+            continue;
+        }
 
         // Start timer.
-#ifdef PRINT_DEBUG
         const auto start_time = std::chrono::high_resolution_clock::now();
-#endif
+        bool solved = false;
 
-        // Skip running A* if the penalties in the last iteration of this agent have stayed the same or worsened.
+        // Skip running A* if the penalties in the last iteration of this agent have stayed the same or worsened and
+        // the optimal cost of the last iteration shows that no path can have negative reduced cost. Paths in Farkas
+        // pricing exclude the step costs so a reduced cost pricing run cannot bound a Farkas pricing run.
 #ifdef USE_ASTAR_SOLUTION_CACHING
-        if (!astar.data().can_be_better(pricerdata->previous_data[a]))
+        if ((!is_farkas || pricerdata->previous_is_farkas[a]) &&
+            SCIPisSumGE(scip,
+                        astar.data().lower_bound(pricerdata->previous_data[a], pricerdata->previous_cost[a]),
+                        0.0))
         {
             goto FINISHED_PRICING_AGENT;
         }
 #endif
 
         // Solve.
-        astar.before_solve(); 
+        solved = true;
+        astar.before_solve();
 #ifdef USE_SIPP
         std::tie(path_vertices, path_cost) = astar.solve_sipp<is_farkas>();
 #ifdef DEBUG
@@ -1170,7 +1441,6 @@ SCIP_RETCODE run_trufflehog_pricer(
                 debug_assert(var);
                 found = true;
                 order[order_idx].new_var = var;
-                pricerdata->price_priority[a]++;
 #ifdef PRINT_DEBUG
                 nb_new_cols++;
 #endif
@@ -1178,17 +1448,10 @@ SCIP_RETCODE run_trufflehog_pricer(
                 // Update reservation table.
 #ifdef USE_RESERVATION_TABLE
                 {
-                    Node n;
-                    Time t = 0;
-                    for (; t < static_cast<Time>(path.size()); ++t)
-                    {
-                        n = path[t].n;
-                        restab.reserve(NodeTime{n, t});
-                    }
-                    for (; t < makespan; ++t)
-                    {
-                        restab.reserve(NodeTime{n, t});
-                    }
+                    const auto path_length = static_cast<Time>(path.size());
+                    const auto end = std::max(path_length, makespan);
+                    update_path_reservation<true>(restab, path_length, path.data(), 0, end);
+                    pricerdata->reserved_vars[var] = end;
                 }
 #endif
 
@@ -1197,23 +1460,44 @@ SCIP_RETCODE run_trufflehog_pricer(
             }
         }
 
-        // Store the penalties of the run.
+        // Store the penalties and the optimal cost of a run that found no column. Runs that found a column are not
+        // stored since their negative optimal cost rarely bounds a later run above zero. A* discards paths with
+        // non-negative cost so the optimal cost is only known to be non-negative if no path is found.
 #ifdef USE_ASTAR_SOLUTION_CACHING
-        pricerdata->previous_data[a] = astar.data();
+        if (pricerdata->cache_solutions)
+        {
+            pricerdata->previous_data[a] = astar.data();
+            pricerdata->previous_cost[a] = !path_vertices.empty() ? path_cost : 0.0;
+            pricerdata->previous_is_farkas[a] = is_farkas;
+        }
 #endif
 
         // End of this agent.
         FINISHED_PRICING_AGENT:
         agent_priced[a] = true;
 
-        // End timer.
-#ifdef PRINT_DEBUG
-        const auto end_time = std::chrono::high_resolution_clock::now();
-        const auto duration = std::chrono::duration<double>(end_time - start_time).count();
-        debugln("    Done in {:.4f} seconds", duration);
-#endif
+        // End timer and update statistics.
+        {
+            const auto end_time = std::chrono::high_resolution_clock::now();
+            const auto duration = std::chrono::duration<double>(end_time - start_time).count();
+            if (solved)
+            {
+                const auto found_column = !path_vertices.empty() && SCIPisSumLT(scip, path_cost, 0.0);
+                update_pricing_statistics(stats, duration, found_column ? path_cost : 0.0);
+            }
+            else
+            {
+                stats.nb_skipped_cache++;
+            }
+            debugln("    Done in {:.4f} seconds", duration);
+        }
     }
 
+    // Forget the SIPP intervals common to all agents so that they are not used after this round.
+#ifdef USE_SIPP
+    astar.clear_shared_edge_penalties();
+#endif
+
     // Print.
     debugln("Added {} new columns", nb_new_cols);
 
@@ -1281,6 +1565,38 @@ SCIP_RETCODE SCIPincludePricerTruffleHog(
     SCIP_CALL(SCIPsetPricerInit(scip, pricer, pricerTruffleHogInit));
     SCIP_CALL(SCIPsetPricerFree(scip, pricer, pricerTruffleHogFree));
 
+    // Add parameters.
+    SCIP_CALL(SCIPaddRealParam(scip,
+                               "pricers/" PRICER_NAME "/memorybudget",
+                               "maximal memory usage in MB before the caches of the pricer are freed",
+                               nullptr,
+                               FALSE,
+                               DEFAULT_MEMORY_BUDGET,
+                               0.0,
+                               SCIP_MEM_NOLIMIT,
+                               nullptr,
+                               nullptr));
+    SCIP_CALL(SCIPaddRealParam(scip,
+                               "pricers/" PRICER_NAME "/frontiermemory",
+                               "memory in MB shared by the dense time layers of the frontiers of the low-level searches",
+                               nullptr,
+                               FALSE,
+                               DEFAULT_FRONTIER_MEMORY,
+                               0.0,
+                               SCIP_MEM_NOLIMIT,
+                               nullptr,
+                               nullptr));
+    SCIP_CALL(SCIPaddIntParam(scip,
+                              "pricers/" PRICER_NAME "/labelpoolblocksize",
+                              "size in MB of each block of memory holding the labels of the low-level searches",
+                              nullptr,
+                              FALSE,
+                              DEFAULT_LABEL_POOL_BLOCK_SIZE,
+                              1,
+                              1024,
+                              nullptr,
+                              nullptr));
+
     // Done.
     return SCIP_OKAY;
 }
@@ -1303,3 +1619,138 @@ SCIP_RETCODE SCIPpricerTruffleHogActivate(
     // Done.
     return SCIP_OKAY;
 }
+
+// Get the bytes of memory used by the inputs to the previous run of each agent
+size_t SCIPpricerTruffleHogGetSolutionCacheBytes(
+    SCIP* scip    // SCIP
+)
+{
+    // Check.
+    debug_assert(scip);
+
+    // Get pricer data.
+    auto pricer = SCIPfindPricer(scip, PRICER_NAME);
+    debug_assert(pricer);
+    auto pricerdata = SCIPpricerGetData(pricer);
+    if (!pricerdata)
+    {
+        return 0;
+    }
+
+    // Sum the inputs of every agent.
+    size_t bytes = 0;
+#ifdef USE_ASTAR_SOLUTION_CACHING
+    bytes += vector_bytes(pricerdata->previous_data) +
+             vector_bytes(pricerdata->previous_cost) +
+             pricerdata->previous_is_farkas.capacity() / 8;
+    for (const auto& data : pricerdata->previous_data)
+    {
+        bytes += data.memory_bytes();
+    }
+#endif
+    return bytes;
+}
+
+// Free the inputs to the previous run of each agent and stop storing them
+void SCIPpricerTruffleHogClearSolutionCache(
+    SCIP* scip    // SCIP
+)
+{
+    // Check.
+    debug_assert(scip);
+
+    // Get pricer data.
+    auto pricer = SCIPfindPricer(scip, PRICER_NAME);
+    debug_assert(pricer);
+    auto pricerdata = SCIPpricerGetData(pricer);
+    if (!pricerdata)
+    {
+        return;
+    }
+
+    // Free the inputs. A previous cost of negative infinity never skips a run.
+#ifdef USE_ASTAR_SOLUTION_CACHING
+    for (Agent a = 0; a < pricerdata->N; ++a)
+    {
+        pricerdata->previous_data[a] = AStar::Data();
+        pricerdata->previous_cost[a] = -std::numeric_limits<SCIP_Real>::infinity();
+    }
+    pricerdata->cache_solutions = false;
+#endif
+}
+
+// Print statistics of pricing each agent
+SCIP_RETCODE SCIPpricerTruffleHogPrintStatistics(
+    SCIP* scip    // SCIP
+)
+{
+    // Check.
+    debug_assert(scip);
+
+    // Get pricer data.
+    auto pricer = SCIPfindPricer(scip, PRICER_NAME);
+    debug_assert(pricer);
+    auto pricerdata = SCIPpricerGetData(pricer);
+    if (!pricerdata)
+    {
+        return SCIP_OKAY;
+    }
+
+    // Print.
+    println("Agent pricing      :      Calls    Columns    Success  Avg time (s)  Total time (s)  Avg red cost"
+            "      Score  Bound skips  Cache skips");
+    AgentPricingStatistics total{};
+    for (Agent a = 0; a < pricerdata->N; ++a)
+    {
+        const auto& stats = pricerdata->pricing_stats[a];
+        println("  {:<17}: {:>10} {:>10} {:>10.4f} {:>13.6f} {:>15.4f} {:>13.4f} {:>10.2f} {:>12} {:>12}",
+                a,
+                stats.nb_calls,
+                stats.nb_columns,
+                stats.success_rate,
+                stats.avg_time,
+                stats.total_time,
+                stats.avg_reduced_cost,
+                pricing_score(stats),
+                stats.nb_skipped_bound,
+                stats.nb_skipped_cache);
+        total.nb_calls += stats.nb_calls;
+        total.nb_columns += stats.nb_columns;
+        total.total_time += stats.total_time;
+        total.nb_skipped_bound += stats.nb_skipped_bound;
+        total.nb_skipped_cache += stats.nb_skipped_cache;
+    }
+    println("  {:<17}: {:>10} {:>10} {:>10.4f} {:>13.6f} {:>15.4f} {:>13} {:>10} {:>12} {:>12}",
+            "total",
+            total.nb_calls,
+            total.nb_columns,
+            total.nb_calls > 0 ? static_cast<SCIP_Real>(total.nb_columns) / total.nb_calls : 0.0,
+            total.nb_calls > 0 ? total.total_time / total.nb_calls : 0.0,
+            total.total_time,
+            "-",
+            "-",
+            total.nb_skipped_bound,
+            total.nb_skipped_cache);
+
+    // Print label pool statistics of the low-level solver.
+    {
+        auto probdata = SCIPgetProbData(scip);
+        debug_assert(probdata);
+        const auto& astar = SCIPprobdataGetAStar(probdata);
+        const auto& pool_stats = astar.label_pool_statistics();
+        println("Label pool         :   Searches     Blocks Peak blocks  Peak (MiB)  Trimmed  Peak labels  Avg labels");
+        println("  {:<17}: {:>10} {:>10} {:>11} {:>11.1f} {:>8} {:>12} {:>11.0f}",
+                "low-level solver",
+                pool_stats.nb_searches,
+                pool_stats.nb_blocks,
+                pool_stats.peak_blocks,
+                pool_stats.peak_bytes / (1024.0 * 1024.0),
+                pool_stats.nb_trimmed_blocks,
+                pool_stats.peak_labels,
+                pool_stats.nb_searches > 0 ?
+                static_cast<SCIP_Real>(pool_stats.total_labels) / pool_stats.nb_searches : 0.0);
+    }
+
+    // Done.
+    return SCIP_OKAY;
+}
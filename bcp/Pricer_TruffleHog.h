@@ -33,4 +33,19 @@ SCIP_RETCODE SCIPpricerTruffleHogActivate(
     SCIP* scip    // SCIP
 );
 
+// Get the bytes of memory used by the inputs to the previous run of each agent
+size_t SCIPpricerTruffleHogGetSolutionCacheBytes(
+    SCIP* scip    // SCIP
+);
+
+// Free the inputs to the previous run of each agent and stop storing them
+void SCIPpricerTruffleHogClearSolutionCache(
+    SCIP* scip    // SCIP
+);
+
+// Print statistics of pricing each agent
+SCIP_RETCODE SCIPpricerTruffleHogPrintStatistics(
+    SCIP* scip    // SCIP
+);
+
 #endif
@@ -27,9 +27,14 @@ Author: Edward Lam <ed@ed-lam.com>
 #define REMOVE_PADDING
 #endif
 
+#define COLUMN_AGE_LIMIT          (50)     // Pricing rounds a variable can be unused before it is purged
+#define COLUMN_PURGE_MIN_NB       (1000)   // Minimum number of old variables to purge at once
+#define COLUMN_PURGE_MIN_FRACTION (0.1)    // Minimum fraction of old variables to purge at once
+
 #include "ProblemData.h"
 #include "VariableData.h"
 #include "Pricer_TruffleHog.h"
+#include "Checkpoint.h"
 #include "scip/cons_setppc.h"
 #include "scip/cons_knapsack.h"
 #include "ConstraintHandler_VertexConflicts.h"
@@ -126,6 +131,8 @@ struct SCIP_ProbData
     Vector<SCIP_VAR*> dummy_vars;                                               // Array of dummy variables
     Vector<Pair<SCIP_VAR*, SCIP_Real>> vars;                                    // Array of variables for all agents
     Vector<Vector<Pair<SCIP_VAR*, SCIP_Real>>> agent_vars;                      // Array of variables for each agent
+    Vector<SCIP_VAR*> purged_vars;                                              // Array of variables purged for being unused
+    Int nb_purges;                                                              // Number of times variables are purged
 #if defined(USE_THREEVERTEX_CONFLICTS) || defined(USE_VERTEX_FOUREDGE_CONFLICTS)
     Vector<HashTable<NodeTime, SCIP_Real>> fractional_vertices;                 // Vertices with fractional values
 #endif
@@ -157,6 +164,7 @@ struct SCIP_ProbData
 #ifdef USE_PATH_LENGTH_NOGOODS
     Vector<PathLengthNogood> path_length_nogoods;                               // Path length nogoods
 #endif
+    CheckpointCuts checkpoint_cuts;                                             // Cuts of a checkpoint not yet in the LP
 
     // Constraints separated by agent for fast retrieval
     Vector<Vector<AgentRobustCut>> agent_robust_cuts;                           // Two-agent robust cuts grouped by agent
@@ -214,6 +222,7 @@ SCIP_DECL_PROBTRANS(probtrans)
 
         (*targetdata)->agent_vars[a].emplace_back(var, 0);
     }
+    (*targetdata)->nb_purges = 0;
 
     // Copy dummy variables.
     debug_assert(static_cast<Agent>(sourcedata->dummy_vars.size()) == N);
@@ -386,6 +395,12 @@ SCIP_RETCODE probdataFree(
             SCIP_CALL(SCIPreleaseVar(scip, &var));
         }
 
+    // Release purged variables.
+    for (auto& var : (*probdata)->purged_vars)
+    {
+        SCIP_CALL(SCIPreleaseVar(scip, &var));
+    }
+
     // Release agent partition constraints.
     for (auto& cons : (*probdata)->agent_part)
     {
@@ -1031,17 +1046,124 @@ SCIP_RETCODE SCIPprobdataAddPricedVar(
     return SCIP_OKAY;
 }
 
+// Age the variables and move the variables unused for many pricing rounds out of the master problem
+SCIP_RETCODE SCIPprobdataPurgeVars(
+    SCIP* scip,                 // SCIP
+    SCIP_ProbData* probdata     // Problem data
+)
+{
+    // Check.
+    debug_assert(scip);
+    debug_assert(probdata);
+
+    // Age the variables. A variable is unused if it is zero and its column is not in the LP or has non-negative
+    // reduced cost. Since the pricer adds about one variable for each agent in a round, the number of variables kept
+    // without being used stays around N times the age limit.
+    auto& vars = probdata->vars;
+    size_t nb_old = 0;
+    for (const auto& [var, var_val] : vars)
+    {
+        debug_assert(var_val == SCIPgetSolVal(scip, nullptr, var));
+        const auto unused = SCIPisZero(scip, var_val) &&
+                            (SCIPvarGetStatus(var) != SCIP_VARSTATUS_COLUMN ||
+                             !SCIPcolIsInLP(SCIPvarGetCol(var)) ||
+                             !SCIPisDualfeasNegative(scip, SCIPgetVarRedcost(scip, var)));
+        auto vardata = SCIPvarGetData(var);
+        const auto age = unused ? SCIPvardataGetAge(vardata) + 1 : 0;
+        SCIPvardataSetAge(vardata, age);
+        nb_old += (age >= COLUMN_AGE_LIMIT);
+    }
+
+    // Purge only when many variables are old because the branching decisions check every variable again after a
+    // purge.
+    if (nb_old < std::max<size_t>(COLUMN_PURGE_MIN_NB, static_cast<size_t>(COLUMN_PURGE_MIN_FRACTION * vars.size())))
+    {
+        return SCIP_OKAY;
+    }
+
+    // Keep the variables of the incumbent to output the solution.
+    auto best_sol = SCIPgetBestSol(scip);
+    const auto is_purged = [scip, best_sol](SCIP_VAR* var)
+    {
+        return SCIPvardataGetAge(SCIPvarGetData(var)) >= COLUMN_AGE_LIMIT &&
+               !(best_sol && SCIPgetSolVal(scip, best_sol, var) > 0.5);
+    };
+
+    // Move the old variables to the pool of purged variables. Fix them to zero in every node because the cuts found
+    // from now on do not contain them. The pricer generates their paths again when they are needed.
+    TRACE_SCOPE("purge_vars");
+    auto& purged_vars = probdata->purged_vars;
+#ifdef PRINT_DEBUG
+    const auto nb_previous_purged_vars = purged_vars.size();
+#endif
+    size_t nb_kept = 0;
+    for (size_t idx = 0; idx < vars.size(); ++idx)
+    {
+        const auto var = vars[idx].first;
+        if (is_purged(var))
+        {
+            if (SCIPvarGetUbGlobal(var) > 0.5)
+            {
+                SCIP_CALL(SCIPchgVarUbGlobal(scip, var, 0.0));
+            }
+            purged_vars.push_back(var);
+        }
+        else
+        {
+            vars[nb_kept++] = vars[idx];
+        }
+    }
+    vars.resize(nb_kept);
+
+    // Remove the purged variables from the variables of each agent and release their second capture.
+    for (auto& agent_vars : probdata->agent_vars)
+    {
+        nb_kept = 0;
+        for (size_t idx = 0; idx < agent_vars.size(); ++idx)
+        {
+            auto var = agent_vars[idx].first;
+            if (is_purged(var))
+            {
+                SCIP_CALL(SCIPreleaseVar(scip, &var));
+            }
+            else
+            {
+                agent_vars[nb_kept++] = agent_vars[idx];
+            }
+        }
+        agent_vars.resize(nb_kept);
+    }
+
+    // Mark the branching decisions for checking every variable again since the variables have moved.
+    probdata->nb_purges++;
+
+    // Print.
+#ifdef PRINT_DEBUG
+    debugln("Purged {} variables unused for {} pricing rounds, {} variables remaining",
+            purged_vars.size() - nb_previous_purged_vars,
+            COLUMN_AGE_LIMIT,
+            vars.size());
+#endif
+
+    // Done.
+    return SCIP_OKAY;
+}
+
 // Add a new two-agent robust cut
 SCIP_RETCODE SCIPprobdataAddTwoAgentRobustCut(
-    SCIP* scip,                 // SCIP
-    SCIP_ProbData* probdata,    // Problem data
-    SCIP_SEPA* sepa,            // Separator
-    TwoAgentRobustCut&& cut,    // Data for the cut
-    const SCIP_Real rhs,        // RHS
-    SCIP_RESULT* result,        // Output result
-    Int* idx                    // Output index of the cut
+    SCIP* scip,                             // SCIP
+    SCIP_ProbData* probdata,                // Problem data
+    SCIP_SEPA* sepa,                        // Separator
+    TwoAgentRobustCut&& cut,                // Data for the cut
+    const SCIP_Real rhs,                    // RHS
+    SCIP_RESULT* result,                    // Output result
+    Int* idx,                               // Output index of the cut
+    [[maybe_unused]] const bool violated    // Is the cut violated by the current solution?
 )
 {
+    // Trace.
+    TRACE_SCOPE("create_row");
+
     // Create a row.
     SCIP_ROW* row = nullptr;
     SCIP_CALL(SCIPcreateEmptyRowSepa(scip,
@@ -1109,7 +1231,7 @@ SCIP_RETCODE SCIPprobdataAddTwoAgentRobustCut(
         }
     SCIP_CALL(SCIPflushRowExtensions(scip, row));
 #ifdef DEBUG
-    debug_assert(SCIPisSumGT(scip, lhs, rhs));
+    debug_assert(!violated || SCIPisSumGT(scip, lhs, rhs));
 #endif
 
     // Check agent and edges.
@@ -1287,6 +1409,7 @@ SCIP_RETCODE SCIPprobdataCreate(
     // Copy model data.
     probdata->pricerdata = nullptr;
     probdata->astar = astar;
+    probdata->nb_purges = 0;
 
     // Create agent partition constraints.
     probdata->agent_part.resize(N);
@@ -1564,6 +1687,24 @@ Vector<Vector<Pair<SCIP_VAR*, SCIP_Real>>>& SCIPprobdataGetAgentVars(
     return probdata->agent_vars;
 }
 
+// Get array of variables purged from the master problem
+const Vector<SCIP_VAR*>& SCIPprobdataGetPurgedVars(
+    SCIP_ProbData* probdata    // Problem data
+)
+{
+    debug_assert(probdata);
+    return probdata->purged_vars;
+}
+
+// Get the number of times variables are purged
+Int SCIPprobdataGetNPurges(
+    SCIP_ProbData* probdata    // Problem data
+)
+{
+    debug_assert(probdata);
+    return probdata->nb_purges;
+}
+
 // Get agent partition constraints
 Vector<SCIP_CONS*>& SCIPprobdataGetAgentPartConss(
     SCIP_ProbData* probdata    // Problem data
@@ -1774,6 +1915,9 @@ void update_fractional_vertices_and_edges(
     SCIP* scip    // SCIP
 )
 {
+    // Trace.
+    TRACE_SCOPE("update_fractional_vertices_and_edges");
+
     // Print.
     debugln("Updating fractional vertices and edges");
 
@@ -2070,6 +2214,14 @@ bool& SCIPprobdataGetFoundCutsIndicator(
     return probdata->found_cuts;
 }
 
+// Get cuts of a checkpoint waiting to be added to the LP
+CheckpointCuts& SCIPprobdataGetCheckpointCuts(
+    SCIP_ProbData* probdata    // Problem data
+)
+{
+    return probdata->checkpoint_cuts;
+}
+
 // Get the scenario path
 const std::filesystem::path& SCIPprobdataGetScenarioPath(
     SCIP_ProbData* probdata    // Problem data
@@ -27,6 +27,8 @@ Author: Edward Lam <ed@ed-lam.com>
 #include "trufflehog/Instance.h"
 #include "trufflehog/AStar.h"
 
+struct CheckpointCuts;
+
 #ifdef USE_GOAL_CONFLICTS
 struct GoalConflict
 {
@@ -84,6 +86,12 @@ SCIP_RETCODE SCIPprobdataAddPricedVar(
     SCIP_VAR** var              // Output new variable
 );
 
+// Age the variables and move the variables unused for many pricing rounds out of the master problem
+SCIP_RETCODE SCIPprobdataPurgeVars(
+    SCIP* scip,                 // SCIP
+    SCIP_ProbData* probdata     // Problem data
+);
+
 // Add a new two-agent robust cut
 SCIP_RETCODE SCIPprobdataAddTwoAgentRobustCut(
     SCIP* scip,                 // SCIP
@@ -92,7 +100,8 @@ SCIP_RETCODE SCIPprobdataAddTwoAgentRobustCut(
     TwoAgentRobustCut&& cut,    // Data for the cut
     const SCIP_Real rhs,        // RHS
     SCIP_RESULT* result,        // Output result
-    Int* idx = nullptr          // Output index of the cut
+    Int* idx = nullptr,         // Output index of the cut
+    const bool violated = true  // Is the cut violated by the current solution?
 );
 
 // Get array of dummy variables
@@ -110,6 +119,16 @@ Vector<Vector<Pair<SCIP_VAR*, SCIP_Real>>>& SCIPprobdataGetAgentVars(
     SCIP_ProbData* probdata    // Problem data
 );
 
+// Get array of variables purged from the master problem
+const Vector<SCIP_VAR*>& SCIPprobdataGetPurgedVars(
+    SCIP_ProbData* probdata    // Problem data
+);
+
+// Get the number of times variables are purged
+Int SCIPprobdataGetNPurges(
+    SCIP_ProbData* probdata    // Problem data
+);
+
 // Get agent partition constraints
 Vector<SCIP_CONS*>& SCIPprobdataGetAgentPartConss(
     SCIP_ProbData* probdata    // Problem data
@@ -254,6 +273,11 @@ bool& SCIPprobdataGetFoundCutsIndicator(
     SCIP_ProbData* probdata    // Problem data
 );
 
+// Get cuts of a checkpoint waiting to be added to the LP
+CheckpointCuts& SCIPprobdataGetCheckpointCuts(
+    SCIP_ProbData* probdata    // Problem data
+);
+
 // Get the scenario path
 const std::filesystem::path& SCIPprobdataGetScenarioPath(
     SCIP_ProbData* probdata    // Problem data
@@ -20,6 +20,8 @@ Author: Edward Lam <ed@ed-lam.com>
 #include "Reader.h"
 #include "Includes.h"
 #include "ProblemData.h"
+#include "VariableData.h"
+#include <fstream>
 #include <regex>
 
 #include "trufflehog/Instance.h"
@@ -30,7 +32,8 @@ SCIP_RETCODE read_instance(
     SCIP* scip,                                    // SCIP
     const std::filesystem::path& scenario_path,    // File path to scenario
     const Agent nb_agents,                         // Number of agents to read
-    const int time_spacing                         // Time-spacing parameter
+    const int time_spacing,                        // Time-spacing parameter
+    InstanceCache* cache                           // Maps and lower bounds of previous instances
 )
 {
     // Get instance name.
@@ -41,14 +44,155 @@ SCIP_RETCODE read_instance(
     }
 
     // Load instance.
-    auto instance = std::make_shared<Instance>(scenario_path, nb_agents);
+    auto instance = std::make_shared<Instance>(scenario_path, nb_agents, time_spacing, cache ? &cache->maps : nullptr);
 
     // Create pricing solver.
     auto astar = std::make_shared<AStar>(instance->map);
 
+    // Share the lower bounds with other instances on the same map.
+    if (cache)
+    {
+        auto& shared_h = cache->heuristics[instance->map_path.string()];
+        if (!shared_h)
+        {
+            shared_h = std::make_shared<HeuristicTables>();
+        }
+        astar->set_shared_h(shared_h);
+    }
+
     // Create the problem.
     SCIP_CALL(SCIPprobdataCreate(scip, instance_name.c_str(), instance, astar, time_spacing));
 
     // Done.
     return SCIP_OKAY;
 }
+
+// Read a solution written by write_best_solution, add its paths as columns and submit it as a primal solution
+SCIP_RETCODE read_initial_solution(
+    SCIP* scip,                                    // SCIP
+    const std::filesystem::path& solution_path     // File path to solution
+)
+{
+    // Get problem data.
+    auto probdata = SCIPgetProbData(scip);
+    const auto N = SCIPprobdataGetN(probdata);
+    const auto& map = SCIPprobdataGetMap(probdata);
+    const auto& agents = SCIPprobdataGetAgentsData(probdata);
+    const auto& agent_vars = SCIPprobdataGetAgentVars(probdata);
+
+    // Open file.
+    std::ifstream solution_file(solution_path);
+    release_assert(solution_file.good(), "Cannot find solution file {}", solution_path.string());
+
+    // Check if the file has a solution.
+    String line;
+    if (!std::getline(solution_file, line) || line == "-")
+    {
+        println("Solution file {} has no solution", solution_path.string());
+        return SCIP_OKAY;
+    }
+
+    // Read the path of each agent. The positions are written without the padding of the map. Ignore agents not in the
+    // instance.
+    Vector<Vector<Edge>> paths(N);
+    const std::regex agent_regex(R"(Agent (\d+), cost \d+, path (.*))");
+    const std::regex position_regex(R"(\((\d+),(\d+)\))");
+    while (std::getline(solution_file, line))
+    {
+        std::smatch agent_match;
+        if (!std::regex_match(line, agent_match, agent_regex))
+            continue;
+
+        const Agent a = std::stoi(agent_match[1]);
+        if (a >= N)
+            continue;
+        release_assert(paths[a].empty(), "Agent {} has more than one path in solution file", a);
+
+        auto& path = paths[a];
+        const auto positions = agent_match[2].str();
+        for (std::sregex_iterator it(positions.begin(), positions.end(), position_regex), end; it != end; ++it)
+        {
+            const Position x = std::stoi((*it)[1]) + 1;
+            const Position y = std::stoi((*it)[2]) + 1;
+            release_assert(x < map.width() - 1 && y < map.height() - 1 && map[map.get_id(x, y)],
+                           "Path of agent {} visits obstacle ({},{})",
+                           a, x - 1, y - 1);
+            path.emplace_back(Edge{map.get_id(x, y), Direction::INVALID});
+        }
+    }
+
+    // Check the paths and calculate the directions.
+    bool complete = true;
+    for (Agent a = 0; a < N; ++a)
+    {
+        auto& path = paths[a];
+        if (path.empty())
+        {
+            complete = false;
+            continue;
+        }
+        release_assert(path.front().n == agents[a].start, "Path of agent {} does not start at its start", a);
+        release_assert(path.back().n == agents[a].goal, "Path of agent {} does not end at its goal", a);
+        for (Time t = 0; t < static_cast<Time>(path.size()) - 1; ++t)
+        {
+            const auto n = path[t].n;
+            const auto next_n = path[t + 1].n;
+            release_assert(next_n == map.get_north(n) ||
+                           next_n == map.get_south(n) ||
+                           next_n == map.get_east(n) ||
+                           next_n == map.get_west(n) ||
+                           next_n == map.get_wait(n),
+                           "Path of agent {} jumps between non-adjacent positions at time {}",
+                           a, t);
+            path[t].d = map.get_direction(n, next_n);
+        }
+    }
+
+    // Add the paths as columns unless already in the master problem.
+    Vector<SCIP_VAR*> vars(N, nullptr);
+    for (Agent a = 0; a < N; ++a)
+    {
+        const auto& path = paths[a];
+        if (path.empty())
+            continue;
+
+        for (const auto& [var, _] : agent_vars[a])
+        {
+            debug_assert(var);
+            auto vardata = SCIPvarGetData(var);
+            const auto existing_path_length = SCIPvardataGetPathLength(vardata);
+            const auto existing_path = SCIPvardataGetPath(vardata);
+            if (std::equal(path.begin(), path.end(), existing_path, existing_path + existing_path_length))
+            {
+                vars[a] = var;
+                break;
+            }
+        }
+        if (!vars[a])
+        {
+            SCIP_CALL(SCIPprobdataAddInitialVar(scip, probdata, a, path.size(), path.data(), &vars[a]));
+            debug_assert(vars[a]);
+        }
+    }
+
+    // Submit the solution if every agent has a path.
+    if (!complete)
+    {
+        println("Solution file {} is missing paths for some agents. Only adding columns", solution_path.string());
+        return SCIP_OKAY;
+    }
+    SCIP_SOL* sol = nullptr;
+    SCIP_CALL(SCIPcreateSol(scip, &sol, nullptr));
+    for (Agent a = 0; a < N; ++a)
+    {
+        SCIP_CALL(SCIPsetSolVal(scip, sol, vars[a], 1.0));
+    }
+    const auto obj = SCIPgetSolOrigObj(scip, sol);
+    SCIP_Bool success;
+    SCIP_CALL(SCIPtrySol(scip, sol, TRUE, TRUE, FALSE, TRUE, TRUE, &success));
+    SCIP_CALL(SCIPfreeSol(scip, &sol));
+    println("Initial solution with cost {:.0f} is {}", obj, success ? "accepted" : "infeasible");
+
+    // Done.
+    return SCIP_OKAY;
+}
@@ -23,12 +23,29 @@ Author: Edward Lam <ed@ed-lam.com>
 #include "Includes.h"
 #include <filesystem>
 
+#include "trufflehog/Instance.h"
+#include "trufflehog/Heuristic.h"
+
+// Maps and lower bounds shared by the instances solved in one process
+struct InstanceCache
+{
+    MapCache maps;                                                   // Maps indexed by path
+    HashTable<String, std::shared_ptr<HeuristicTables>> heuristics;  // Lower bounds indexed by the path to the map
+};
+
 // Read instance from file
 SCIP_RETCODE read_instance(
     SCIP* scip,                                                  // SCIP
     const std::filesystem::path& scenario_path,                  // File path to scenario
     const Agent nb_agents = std::numeric_limits<Agent>::max(),   // Number of agents to read
-    const int time_spacing = 0                                   // Time-spacing parameter
+    const int time_spacing = 0,                                  // Time-spacing parameter
+    InstanceCache* cache = nullptr                               // Maps and lower bounds of previous instances
+);
+
+// Read a solution written by write_best_solution, add its paths as columns and submit it as a primal solution
+SCIP_RETCODE read_initial_solution(
+    SCIP* scip,                                                  // SCIP
+    const std::filesystem::path& solution_path                   // File path to solution
 );
 
 #endif
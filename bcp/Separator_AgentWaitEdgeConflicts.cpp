@@ -543,6 +543,7 @@ SCIP_DECL_SEPAEXECLP(sepaExeclpAgentWaitEdgeConflicts)
     *result = SCIP_DIDNOTFIND;
 
     // Start separator.
+    TRACE_SCOPE(SEPA_NAME);
     SCIP_CALL(agentwaitedge_conflicts_separate(scip, sepa, result));
 
     // Done.
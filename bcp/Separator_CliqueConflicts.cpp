@@ -621,6 +621,7 @@ SCIP_DECL_SEPAEXECLP(sepaExeclpCliqueConflicts)
     *result = SCIP_DIDNOTFIND;
 
     // Start separator.
+    TRACE_SCOPE(SEPA_NAME);
     SCIP_CALL(clique_conflicts_separate(scip, sepa, result));
 
     // Done.
@@ -349,6 +349,7 @@ SCIP_DECL_SEPAEXECLP(sepaExeclpCorridorConflicts)
     *result = SCIP_DIDNOTFIND;
 
     // Start separator.
+    TRACE_SCOPE(SEPA_NAME);
     SCIP_CALL(corridor_conflicts_separate(scip, sepa, result));
 
     // Done.
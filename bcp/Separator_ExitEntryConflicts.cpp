@@ -289,6 +289,7 @@ SCIP_DECL_SEPAEXECLP(sepaExeclpExitEntryConflicts)
     *result = SCIP_DIDNOTFIND;
 
     // Start separator.
+    TRACE_SCOPE(SEPA_NAME);
     SCIP_CALL(exitentry_conflicts_separate(scip, sepa, result));
 
     // Done.
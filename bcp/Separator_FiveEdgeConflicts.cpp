@@ -285,6 +285,7 @@ SCIP_DECL_SEPAEXECLP(sepaExeclpFiveEdgeConflicts)
     *result = SCIP_DIDNOTFIND;
 
     // Start separator.
+    TRACE_SCOPE(SEPA_NAME);
     SCIP_CALL(fiveedge_conflicts_separate(scip, sepa, result));
 
     // Done.
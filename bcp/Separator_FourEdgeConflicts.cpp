@@ -275,6 +275,7 @@ SCIP_DECL_SEPAEXECLP(sepaExeclpFourEdgeConflicts)
     *result = SCIP_DIDNOTFIND;
 
     // Start separator.
+    TRACE_SCOPE(SEPA_NAME);
     SCIP_CALL(fouredge_conflicts_separate(scip, sepa, result));
 
     // Done.
@@ -55,6 +55,9 @@ SCIP_RETCODE goal_conflicts_create_cut(
     SCIP_Result* result                                   // Output result
 )
 {
+    // Trace.
+    TRACE_SCOPE("create_row");
+
     // Get problem data.
     auto probdata = SCIPgetProbData(scip);
 
@@ -422,6 +425,7 @@ SCIP_DECL_SEPAEXECLP(sepaExeclpGoalConflicts)
     *result = SCIP_DIDNOTFIND;
 
     // Start separator.
+    TRACE_SCOPE(SEPA_NAME);
     SCIP_CALL(goal_conflicts_separate(scip, sepa, result));
 
     // Done.
@@ -42,6 +42,9 @@ SCIP_RETCODE path_length_nogoods_create_cut(
     SCIP_Result* result                                      // Output result
 )
 {
+    // Trace.
+    TRACE_SCOPE("create_row");
+
     // Create constraint name.
 #ifdef DEBUG
     String str;
@@ -252,6 +255,7 @@ SCIP_DECL_SEPAEXECLP(sepaExeclpPathLengthNogoods)
     *result = SCIP_DIDNOTFIND;
 
     // Start separator.
+    TRACE_SCOPE(SEPA_NAME);
     SCIP_CALL(path_length_nogoods_separate(scip, sepa, result));
 
     // Done.
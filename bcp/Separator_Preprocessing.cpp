@@ -22,6 +22,7 @@ Author: Edward Lam <ed@ed-lam.com>
 #include "Separator_Preprocessing.h"
 #include "ProblemData.h"
 #include "VariableData.h"
+#include "Checkpoint.h"
 
 #define SEPA_NAME         "preprocessing"
 #define SEPA_DESC         "Separator for preprocessing dummy constraint"
@@ -82,6 +83,13 @@ SCIP_DECL_SEPAEXECLP(sepaExeclpPreprocessing)
     auto& found_cuts = SCIPprobdataGetFoundCutsIndicator(probdata);
     found_cuts = false;
 
+    // Add the cuts of a checkpoint in the first separation round. Skip the other separators in this round.
+    SCIP_CALL(add_checkpoint_cuts(scip, result));
+    if (*result != SCIP_DIDNOTFIND)
+    {
+        found_cuts = true;
+    }
+
     // Done.
     return SCIP_OKAY;
 }
@@ -1268,6 +1268,7 @@ SCIP_DECL_SEPAEXECLP(sepaExeclpRectangleKnapsackConflicts)
     *result = SCIP_DIDNOTFIND;
 
     // Start separator.
+    TRACE_SCOPE(SEPA_NAME);
     SCIP_CALL(rectangle_knapsack_conflicts_separate(scip, sepa, result));
 
     // Done.
@@ -294,6 +294,7 @@ SCIP_DECL_SEPAEXECLP(sepaExeclpSixEdgeConflicts)
     *result = SCIP_DIDNOTFIND;
 
     // Start separator.
+    TRACE_SCOPE(SEPA_NAME);
     SCIP_CALL(sixedge_conflicts_separate(scip, sepa, result));
 
     // Done.
@@ -413,6 +413,7 @@ SCIP_DECL_SEPAEXECLP(sepaExeclpStepAsideConflicts)
     *result = SCIP_DIDNOTFIND;
 
     // Start separator.
+    TRACE_SCOPE(SEPA_NAME);
     SCIP_CALL(stepaside_conflicts_separate(scip, sepa, result));
 
     // Done.
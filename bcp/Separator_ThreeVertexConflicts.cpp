@@ -323,6 +323,7 @@ SCIP_DECL_SEPAEXECLP(sepaExeclpThreeVertexConflicts)
     *result = SCIP_DIDNOTFIND;
 
     // Start separator.
+    TRACE_SCOPE(SEPA_NAME);
     SCIP_CALL(threevertex_conflicts_separate(scip, sepa, result));
 
     // Done.
@@ -397,6 +397,7 @@ SCIP_DECL_SEPAEXECLP(sepaExeclpTwoEdgeConflicts)
     *result = SCIP_DIDNOTFIND;
 
     // Start separator.
+    TRACE_SCOPE(SEPA_NAME);
     SCIP_CALL(twoedge_conflicts_separate(scip, sepa, result));
 
     // Done.
@@ -372,6 +372,7 @@ SCIP_DECL_SEPAEXECLP(sepaExeclpTwoVertexConflicts)
     *result = SCIP_DIDNOTFIND;
 
     // Start separator.
+    TRACE_SCOPE(SEPA_NAME);
     SCIP_CALL(twovertex_conflicts_separate(scip, sepa, result));
 
     // Done.
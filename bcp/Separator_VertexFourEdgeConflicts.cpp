@@ -410,6 +410,7 @@ SCIP_DECL_SEPAEXECLP(sepaExeclpVertexFourEdgeConflicts)
     *result = SCIP_DIDNOTFIND;
 
     // Start separator.
+    TRACE_SCOPE(SEPA_NAME);
     SCIP_CALL(vertexfouredge_conflicts_separate(scip, sepa, result));
 
     // Done.
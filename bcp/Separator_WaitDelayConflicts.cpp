@@ -261,6 +261,7 @@ SCIP_DECL_SEPAEXECLP(sepaExeclpWaitDelayConflicts)
     *result = SCIP_DIDNOTFIND;
 
     // Start separator.
+    TRACE_SCOPE(SEPA_NAME);
     SCIP_CALL(waitdelay_conflicts_separate(scip, sepa, result));
 
     // Done.
@@ -25,6 +25,7 @@ struct SCIP_VarData
 {
     Agent a;             // Agent of the path
     Time path_length;    // Length of the path
+    Int age;             // Number of consecutive pricing rounds in which the path is unused
     Edge path[0];        // Edges in the path
 };
 
@@ -45,6 +46,7 @@ SCIP_RETCODE SCIPvardataCreate(
 
     // Copy data about the agent.
     (*vardata)->a = a;
+    (*vardata)->age = 0;
 
     // Copy data about the path.
     (*vardata)->path_length = path_length;
@@ -174,3 +176,23 @@ const Edge* SCIPvardataGetPath(
     debug_assert(vardata->path);
     return vardata->path;
 }
+
+// Get the number of consecutive pricing rounds in which the path is unused
+Int SCIPvardataGetAge(
+    SCIP_VARDATA* vardata    // Variable data
+)
+{
+    debug_assert(vardata);
+    return vardata->age;
+}
+
+// Set the number of consecutive pricing rounds in which the path is unused
+void SCIPvardataSetAge(
+    SCIP_VARDATA* vardata,    // Variable data
+    const Int age             // Number of pricing rounds
+)
+{
+    debug_assert(vardata);
+    debug_assert(age >= 0);
+    vardata->age = age;
+}
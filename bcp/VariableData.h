@@ -55,4 +55,15 @@ const Edge* SCIPvardataGetPath(
     SCIP_VARDATA* vardata    // Variable data
 );
 
+// Get the number of consecutive pricing rounds in which the path is unused
+Int SCIPvardataGetAge(
+    SCIP_VARDATA* vardata    // Variable data
+);
+
+// Set the number of consecutive pricing rounds in which the path is unused
+void SCIPvardataSetAge(
+    SCIP_VARDATA* vardata,    // Variable data
+    const Int age             // Number of pricing rounds
+);
+
 #endif
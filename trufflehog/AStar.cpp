@@ -20,6 +20,7 @@ Author: Edward Lam <ed@ed-lam.com>
 //#define PRINT_DEBUG
 
 #include "AStar.h"
+#include "Trace.h"
 #include <cstddef>
 
 #define EPS (1e-6)
@@ -50,6 +51,40 @@ static inline void set_bitset(std::byte* const bitset, const Int i)
     bitset[idx] |= mask;
 }
 
+// The goal-crossing state is stored in 64-bit words so that labels can be compared a word at a time
+using StateWord = uint64_t;
+static constexpr Int STATE_WORD_BITS = sizeof(StateWord) * CHAR_BIT;
+
+static inline Int get_state_nb_words(const Int nb_states)
+{
+    return (nb_states + STATE_WORD_BITS - 1) / STATE_WORD_BITS;
+}
+
+static inline StateWord get_state_word(const std::byte* const state, const Int w)
+{
+    StateWord word;
+    memcpy(&word, state + w * sizeof(StateWord), sizeof(StateWord));
+    return word;
+}
+
+#ifdef USE_GOAL_CONFLICTS
+// Add the penalties of the goals crossed in one state but not in another state
+static inline Cost add_crossing_penalties(Cost cost,
+                                          const std::byte* const crossed_state,
+                                          const std::byte* const other_state,
+                                          const Int nb_words,
+                                          const GoalPenalties& goal_penalties)
+{
+    for (Int w = 0; w < nb_words; ++w)
+        for (auto bits = get_state_word(crossed_state, w) & ~get_state_word(other_state, w); bits; bits &= bits - 1)
+        {
+            const auto idx = w * STATE_WORD_BITS + __builtin_ctzll(bits);
+            cost += goal_penalties[idx].cost;
+        }
+    return cost;
+}
+#endif
+
 //static inline void clear_bitset(std::byte* const bitset, const Int i)
 //{
 //    const auto idx = i / CHAR_BIT;
@@ -73,10 +108,37 @@ String make_goal_state_string(const std::byte* const state, const Int nb_goal_cr
 }
 #endif
 
+size_t AStar::Data::memory_bytes() const
+{
+    size_t bytes = vector_bytes(waypoints) +
+                   hash_table_bytes(latest_visit_time) +
+                   edge_penalties.memory_bytes() +
+                   finish_time_penalties.memory_bytes();
+#ifdef USE_GOAL_CONFLICTS
+    bytes += goal_penalties.memory_bytes();
+#endif
+    return bytes;
+}
+
 bool AStar::Data::can_be_better(const Data& previous_data)
 {
-    if (cost_offset < previous_data.cost_offset ||
-        waypoints != previous_data.waypoints ||
+    return cost_offset < previous_data.cost_offset || penalties_can_be_better(previous_data);
+}
+
+Cost AStar::Data::lower_bound(const Data& previous_data, const Cost previous_cost)
+{
+    // Every path not explored by the previous run costs at least the optimal cost of the previous run. If no cost seen
+    // by the previous run has decreased, the optimal cost has changed by at most the change in the cost offset.
+    if (penalties_can_be_better(previous_data))
+    {
+        return -std::numeric_limits<Cost>::infinity();
+    }
+    return previous_cost + (cost_offset - previous_data.cost_offset);
+}
+
+bool AStar::Data::penalties_can_be_better(const Data& previous_data)
+{
+    if (waypoints != previous_data.waypoints ||
         latest_goal_time != previous_data.latest_goal_time ||
         earliest_goal_time != previous_data.earliest_goal_time)
     {
@@ -102,12 +164,14 @@ bool AStar::Data::can_be_better(const Data& previous_data)
             }
         }
 
-    debug_assert(latest_visit_time.size() == previous_data.latest_visit_time.size());
-    for (Node n = 0; n < static_cast<Node>(latest_visit_time.size()); ++n)
-        if (latest_visit_time[n] > previous_data.latest_visit_time[n])
+    for (const auto& [n, previous_latest_visit_time] : previous_data.latest_visit_time)
+    {
+        const auto it = latest_visit_time.find(n);
+        if (it == latest_visit_time.end() || it->second > previous_latest_visit_time)
         {
             return true;
         }
+    }
 
     if (finish_time_penalties.size() != previous_data.finish_time_penalties.size())
     {
@@ -139,23 +203,37 @@ AStar::AStar(const Map& map) :
     map_(map),
 
     data_(),
+    latest_visit_time_(map.latest_visit_time()),
+    latest_visit_time_nodes_(),
 
     h_node_to_waypoint_(nullptr),
     h_waypoint_to_goal_(),
     heuristic_(map),
     label_pool_(),
-#ifdef USE_RESERVATION_TABLE
+#if defined(USE_COMPACT_LABELS) && defined(USE_RESERVATION_TABLE)
+    open_(label_pool_, map.size()),
+#elif defined(USE_COMPACT_LABELS)
+    open_(label_pool_),
+#elif defined(USE_RESERVATION_TABLE)
     open_(map.size()),
 #else
     open_(),
 #endif
-    frontier_without_resources_(),
-    frontier_with_resources_(),
+    frontier_without_resources_(map.size()),
+    frontier_with_resources_(map.size()),
 #ifdef DEBUG
     nb_labels_(0),
 #endif
 
-    sipp_intervals_(map)
+    sipp_intervals_(map),
+
+    bidirectional_search_(map, heuristic_)
+#ifdef USE_FREE_FLIGHT_EXPANSION
+  , latest_penalty_time_(map.size(), -1),
+    penalty_nodes_(),
+    free_flight_path_(),
+    free_flight_failed_(map.size())
+#endif
 {
 }
 
@@ -185,6 +263,7 @@ void AStar::generate_start()
 #ifdef DEBUG
     new_label->label_id = nb_labels_++;
 #endif
+    set_parent(new_label, NO_LABEL);
     const auto h_node_to_waypoint = std::max((*h_node_to_waypoint_)[start], waypoint_time - start_time);
     const auto h_waypoint_to_goal = h_waypoint_to_goal_[0];
     const auto h_goal_to_finish = finish_time_penalties.get_h(start_time + h_node_to_waypoint + h_waypoint_to_goal);
@@ -234,13 +313,16 @@ void AStar::generate_start()
 }
 
 template<bool is_sipp, bool has_resources>
-void AStar::generate_early_segment(Label* const current,
+void AStar::generate_early_segment(const LabelRef current_ref,
                                    const Node next_n,
                                    const Time next_t,
                                    const Cost cost,
                                    const Waypoint w,
                                    const Time waypoint_time)
 {
+    // Get the label being expanded.
+    const auto current = get_label(current_ref);
+
     // Get data.
     const auto& [start,
                  waypoints,
@@ -289,7 +371,7 @@ void AStar::generate_early_segment(Label* const current,
 #ifdef DEBUG
     next_label->label_id = nb_labels_++;
 #endif
-    next_label->parent = current;
+    set_parent(next_label, current_ref);
     next_label->g = current->g + cost;
     next_label->nt = next_nt.nt;
 #ifdef USE_RESERVATION_TABLE
@@ -414,8 +496,11 @@ void AStar::generate_early_segment(Label* const current,
 }
 
 template<bool is_sipp, bool has_resources>
-void AStar::generate_last_segment(Label* const current, const Node next_n, const Time next_t, const Cost cost)
+void AStar::generate_last_segment(const LabelRef current_ref, const Node next_n, const Time next_t, const Cost cost)
 {
+    // Get the label being expanded.
+    const auto current = get_label(current_ref);
+
     // Get data.
     const auto& [start,
                  waypoints,
@@ -462,7 +547,7 @@ void AStar::generate_last_segment(Label* const current, const Node next_n, const
 #ifdef DEBUG
     next_label->label_id = nb_labels_++;
 #endif
-    next_label->parent = current;
+    set_parent(next_label, current_ref);
     next_label->g = current->g + cost;
     next_label->nt = next_nt.nt;
 #ifdef USE_RESERVATION_TABLE
@@ -587,8 +672,11 @@ void AStar::generate_last_segment(Label* const current, const Node next_n, const
 }
 
 template<IntCost default_cost, bool has_resources, bool is_last_segment, class... WaypointArgs>
-void AStar::generate_neighbours(Label* const current, WaypointArgs... waypoint_args)
+void AStar::generate_neighbours(const LabelRef current_ref, WaypointArgs... waypoint_args)
 {
+    // Get the label being expanded.
+    const auto current = get_label(current_ref);
+
     constexpr bool is_sipp = false;
 
     // Get data.
@@ -630,56 +718,29 @@ void AStar::generate_neighbours(Label* const current, WaypointArgs... waypoint_a
     }
 #endif
 
-    // Expand in five directions.
+    // Expand in the five directions with a valid move.
     const auto edge_costs = edge_penalties.get_edge_costs<default_cost>(current->nt);
     const auto current_n = current->n;
     const auto next_t = current->t + 1;
-    if (const auto next_n = map_.get_north(current_n);
-        latest_visit_time[next_n] >= next_t && edge_costs.north < std::numeric_limits<Cost>::infinity())
-    {
-        generate<is_sipp, has_resources, is_last_segment>(current, next_n, next_t, edge_costs.north, waypoint_args...);
-    }
-    if (const auto next_n = map_.get_south(current_n);
-        latest_visit_time[next_n] >= next_t && edge_costs.south < std::numeric_limits<Cost>::infinity())
-    {
-        generate<is_sipp, has_resources, is_last_segment>(current, next_n, next_t, edge_costs.south, waypoint_args...);
-    }
-    if (const auto next_n = map_.get_east(current_n);
-        latest_visit_time[next_n] >= next_t && edge_costs.east < std::numeric_limits<Cost>::infinity())
-    {
-        generate<is_sipp, has_resources, is_last_segment>(current, next_n, next_t, edge_costs.east, waypoint_args...);
-    }
-    if (const auto next_n = map_.get_west(current_n);
-        latest_visit_time[next_n] >= next_t && edge_costs.west < std::numeric_limits<Cost>::infinity())
-    {
-        generate<is_sipp, has_resources, is_last_segment>(current, next_n, next_t, edge_costs.west, waypoint_args...);
-    }
-    if (const auto next_n = map_.get_wait(current_n);
-        latest_visit_time[next_n] >= next_t && edge_costs.wait < std::numeric_limits<Cost>::infinity())
-    {
-        generate<is_sipp, has_resources, is_last_segment>(current, next_n, next_t, edge_costs.wait, waypoint_args...);
-    }
+    const auto moves = map_.get_moves(current_n);
+    for (Int d = 0; d <= Direction::WAIT; ++d)
+        if (moves & (1 << d))
+        {
+            const auto next_n = current_n + map_.get_offset(static_cast<Direction>(d));
+            if (latest_visit_time_[next_n] >= next_t && edge_costs.d[d] < std::numeric_limits<Cost>::infinity())
+            {
+                generate<is_sipp, has_resources, is_last_segment>(current_ref, next_n, next_t, edge_costs.d[d], waypoint_args...);
+            }
+        }
 }
 
 template<IntCost default_cost, bool has_resources, bool is_last_segment, class... WaypointArgs>
-void AStar::generate_neighbours_sipp(Label* const current, WaypointArgs... waypoint_args)
+void AStar::generate_neighbours_sipp(const LabelRef current_ref, WaypointArgs... waypoint_args)
 {
-    constexpr bool is_sipp = true;
+    // Get the label being expanded.
+    const auto current = get_label(current_ref);
 
-    // Get data.
-    auto& [start,
-           waypoints,
-           goal,
-           earliest_goal_time,
-           latest_goal_time,
-           cost_offset,
-           latest_visit_time,
-           edge_penalties,
-           finish_time_penalties
-#ifdef USE_GOAL_CONFLICTS
-         , goal_penalties
-#endif
-    ] = data_;
+    constexpr bool is_sipp = true;
 
     // Get constant.
     constexpr auto inf_cost = std::numeric_limits<Cost>::infinity();
@@ -690,7 +751,7 @@ void AStar::generate_neighbours_sipp(Label* const current, WaypointArgs... waypo
     if (verbose)
     {
 #ifdef USE_GOAL_CONFLICTS
-        const auto nb_goal_penalties = goal_penalties.size();
+        const auto nb_goal_penalties = data_.goal_penalties.size();
 #else
         const auto nb_goal_penalties = 0;
 #endif
@@ -733,9 +794,9 @@ void AStar::generate_neighbours_sipp(Label* const current, WaypointArgs... waypo
             const Cost cost = (default_cost)                * std::max(wait_start - t, 0) +
                               (default_cost + wait_penalty) * (wait_end - wait_start);
             debug_assert(next_t == t + std::max(wait_start - t, 0) + (wait_end - wait_start));
-            if (cost < inf_cost && latest_visit_time[n] >= next_t - 1 && latest_visit_time[next_n] >= next_t)
+            if (cost < inf_cost && latest_visit_time_[n] >= next_t - 1 && latest_visit_time_[next_n] >= next_t)
             {
-                generate<is_sipp, has_resources, is_last_segment>(current, next_n, next_t, cost, waypoint_args...);
+                generate<is_sipp, has_resources, is_last_segment>(current_ref, next_n, next_t, cost, waypoint_args...);
             }
 
             // Only expand to the first of the upcoming wait intervals.
@@ -744,10 +805,17 @@ void AStar::generate_neighbours_sipp(Label* const current, WaypointArgs... waypo
     }
 
     // Expand in the move directions.
+    const auto moves = map_.get_moves(n);
     for (Int d = 0; d < 4; ++d)
     {
+        // Skip moves into obstacles.
+        if (!(moves & (1 << d)))
+        {
+            continue;
+        }
+
         // Get the destination node.
-        const auto next_n = map_.get_destination(n, static_cast<Direction>(d));
+        const auto next_n = n + map_.get_offset(static_cast<Direction>(d));
 
         // Get the outgoing intervals at the current node and the wait intervals at the destination.
         auto [interval, intervals_end] = sipp_intervals_.get_intervals(n, static_cast<Direction>(d));
@@ -769,7 +837,7 @@ void AStar::generate_neighbours_sipp(Label* const current, WaypointArgs... waypo
             if (interval_end > t)
             {
                 debug_assert(interval_start < wait_end);
-                generate_neighbours_one_interval_sipp<default_cost, has_resources, is_last_segment>(current,
+                generate_neighbours_one_interval_sipp<default_cost, has_resources, is_last_segment>(current_ref,
                                                                                                     wait_start,
                                                                                                     wait_end,
                                                                                                     wait_penalty,
@@ -794,7 +862,7 @@ void AStar::generate_neighbours_sipp(Label* const current, WaypointArgs... waypo
                     // Expand at the interval.
                     {
                         const auto [interval_start, interval_end, interval_penalty] = *interval;
-                        generate_neighbours_one_interval_sipp<default_cost, has_resources, is_last_segment>(current,
+                        generate_neighbours_one_interval_sipp<default_cost, has_resources, is_last_segment>(current_ref,
                                                                                                             wait_start,
                                                                                                             wait_end,
                                                                                                             wait_penalty,
@@ -820,7 +888,7 @@ void AStar::generate_neighbours_sipp(Label* const current, WaypointArgs... waypo
                 debug_assert(interval_end > t);
                 if (interval_start < wait_end)
                 {
-                    generate_neighbours_one_interval_sipp<default_cost, has_resources, is_last_segment>(current,
+                    generate_neighbours_one_interval_sipp<default_cost, has_resources, is_last_segment>(current_ref,
                                                                                                         wait_start,
                                                                                                         wait_end,
                                                                                                         wait_penalty,
@@ -838,7 +906,7 @@ void AStar::generate_neighbours_sipp(Label* const current, WaypointArgs... waypo
 }
 
 template<IntCost default_cost, bool has_resources, bool is_last_segment, class... WaypointArgs>
-void AStar::generate_neighbours_one_interval_sipp(Label* const current,
+void AStar::generate_neighbours_one_interval_sipp(const LabelRef current_ref,
                                                   const Time wait_start,
                                                   const Time wait_end,
                                                   const Cost wait_penalty,
@@ -852,25 +920,11 @@ void AStar::generate_neighbours_one_interval_sipp(Label* const current,
 {
     constexpr bool is_sipp = true;
 
-    // Get data.
-    const auto& [start,
-                 waypoints,
-                 goal,
-                 earliest_goal_time,
-                 latest_goal_time,
-                 cost_offset,
-                 latest_visit_time,
-                 edge_penalties,
-                 finish_time_penalties
-#ifdef USE_GOAL_CONFLICTS
-               , goal_penalties
-#endif
-    ] = data_;
-
     // Get constant.
     constexpr auto inf_cost = std::numeric_limits<Cost>::infinity();
 
     // Get current label.
+    const auto current = get_label(current_ref);
     const auto n = current->n;
     const auto t = current->t;
 
@@ -891,9 +945,9 @@ void AStar::generate_neighbours_one_interval_sipp(Label* const current,
                    (default_cost + interval_penalty) * 1;
             debug_assert(next_t == t + std::max(wait_start - t, 0) + (interval_start - wait_start) + 1);
         }
-        if (cost < inf_cost && latest_visit_time[n] >= next_t - 1 && latest_visit_time[next_n] >= next_t)
+        if (cost < inf_cost && latest_visit_time_[n] >= next_t - 1 && latest_visit_time_[next_n] >= next_t)
         {
-            generate<is_sipp, has_resources, is_last_segment>(current, next_n, next_t, cost, waypoint_args...);
+            generate<is_sipp, has_resources, is_last_segment>(current_ref, next_n, next_t, cost, waypoint_args...);
         }
     }
 
@@ -921,16 +975,164 @@ void AStar::generate_neighbours_one_interval_sipp(Label* const current,
                        (default_cost + interval_penalty) * 1;
                 debug_assert(next_t == t + std::max(wait_start - t, 0) + (depart - wait_start) + 1);
             }
-            if (cost < inf_cost && latest_visit_time[n] >= next_t - 1 && latest_visit_time[next_n] >= next_t)
+            if (cost < inf_cost && latest_visit_time_[n] >= next_t - 1 && latest_visit_time_[next_n] >= next_t)
+            {
+                generate<is_sipp, has_resources, is_last_segment>(current_ref, next_n, next_t, cost, waypoint_args...);
+            }
+        }
+    }
+}
+
+#ifdef USE_FREE_FLIGHT_EXPANSION
+void AStar::index_penalty_times()
+{
+    // Reset the nodes of the previous run.
+    for (const auto n : penalty_nodes_)
+    {
+        latest_penalty_time_[n] = -1;
+    }
+    penalty_nodes_.clear();
+    free_flight_failed_.clear();
+
+    // Store the latest time with edge penalties at every node. A node has no penalties after this time.
+    for (const auto& [nt, edge_costs] : data_.edge_penalties)
+    {
+        auto& latest_penalty_time = latest_penalty_time_[nt.n];
+        if (latest_penalty_time < 0)
+        {
+            penalty_nodes_.push_back(nt.n);
+        }
+        latest_penalty_time = std::max(latest_penalty_time, nt.t);
+    }
+}
+
+bool AStar::generate_free_flight(const LabelRef current_ref)
+{
+    // Get the label being expanded.
+    const auto current = get_label(current_ref);
+
+    constexpr IntCost default_cost = 1;
+
+    // Get data.
+    auto& [start,
+           waypoints,
+           goal,
+           earliest_goal_time,
+           latest_goal_time,
+           cost_offset,
+           latest_visit_time,
+           edge_penalties,
+           finish_time_penalties
+#ifdef USE_GOAL_CONFLICTS
+         , goal_penalties
+#endif
+    ] = data_;
+
+    // The f of a label is a lower bound on the cost of every path through it. A shortest path to the goal without
+    // penalties or reserved vertices reaches this bound with the fewest reservations, so it is an optimal extension
+    // of the label if finishing on arrival incurs the lowest finish time penalty.
+    const auto& h = *h_node_to_waypoint_;
+    const auto arrival_time = current->t + h[current->n];
+    if (arrival_time < earliest_goal_time ||
+        arrival_time > latest_goal_time ||
+        isGT(finish_time_penalties.get_penalty(arrival_time), finish_time_penalties.get_h(arrival_time)))
+    {
+        return false;
+    }
+
+    // Descend the heuristic to the goal. The edge penalties only need to be looked up at the node-times at or
+    // before the latest penalty of a node. The descent from a node-time is always the same, so stop at a node-time
+    // from which an earlier descent failed and remember every node-time of a failed descent.
+    free_flight_path_.clear();
+    for (NodeTime nt{current->nt}; nt.t < arrival_time; ++nt.t)
+    {
+        Node next_n = -1;
+        if (!free_flight_failed_.find(nt))
+        {
+            EdgeCosts edge_costs(default_cost);
+            if (nt.t <= latest_penalty_time_[nt.n])
+            {
+                edge_costs = edge_penalties.get_edge_costs<default_cost>(nt);
+            }
+            const auto moves = map_.get_moves(nt.n);
+            for (Int d = 0; d < Direction::WAIT; ++d)
+                if (moves & (1 << d))
+                {
+                    const auto n = nt.n + map_.get_offset(static_cast<Direction>(d));
+                    if (h[n] == h[nt.n] - 1 &&
+                        latest_visit_time_[n] >= nt.t + 1 &&
+                        edge_costs.d[d] == default_cost
+#ifdef USE_RESERVATION_TABLE
+                        && !reservation_table().is_reserved(NodeTime{n, nt.t + 1})
+#endif
+                       )
+                    {
+                        next_n = n;
+                        break;
+                    }
+                }
+        }
+        if (next_n < 0)
+        {
+            free_flight_failed_.try_emplace(current->nt, true);
+            for (Int idx = 0; idx < static_cast<Int>(free_flight_path_.size()); ++idx)
             {
-                generate<is_sipp, has_resources, is_last_segment>(current, next_n, next_t, cost, waypoint_args...);
+                free_flight_failed_.try_emplace(NodeTime{free_flight_path_[idx], current->t + 1 + idx}, true);
             }
+            return false;
         }
+        free_flight_path_.push_back(next_n);
+        nt.n = next_n;
+    }
+
+    // Print.
+#ifdef DEBUG
+    if (verbose)
+    {
+        println("    Free flight from label {} {} (n {}, t {}, nt {}, xy ({},{}), g {}, f {}) to time {}",
+                current->label_id,
+                fmt::ptr(current),
+                decltype(current->n){current->n},
+                decltype(current->t){current->t},
+                decltype(current->nt){current->nt},
+                map_.get_x(current->n),
+                map_.get_y(current->n),
+                current->g,
+                current->f,
+                arrival_time);
     }
+#endif
+
+    // Create the labels along the path without storing them in the priority queue.
+    auto parent = current;
+    auto parent_ref = current_ref;
+    for (const auto n : free_flight_path_)
+    {
+        auto next_label = reinterpret_cast<Label*>(label_pool_.get_label_buffer());
+        memcpy(next_label, parent, label_pool_.label_size());
+#ifdef DEBUG
+        next_label->label_id = nb_labels_++;
+#endif
+        set_parent(next_label, parent_ref);
+        next_label->g = parent->g + default_cost;
+        next_label->nt = NodeTime{n, parent->t + 1}.nt;
+        parent_ref = get_latest_label_ref(next_label);
+        label_pool_.commit_latest_label();
+        parent = next_label;
+    }
+    debug_assert(parent->n == goal);
+
+    // Create the end label.
+    generate_end(parent_ref);
+    return true;
 }
+#endif
 
-void AStar::generate_end(Label* const current)
+void AStar::generate_end(const LabelRef current_ref)
 {
+    // Get the label being expanded.
+    const auto current = get_label(current_ref);
+
     // Get data.
     const auto& [start,
                  waypoints,
@@ -952,7 +1154,7 @@ void AStar::generate_end(Label* const current)
 #ifdef DEBUG
     new_label->label_id = nb_labels_++;
 #endif
-    new_label->parent = current;
+    set_parent(new_label, current_ref);
     debug_assert((*h_node_to_waypoint_)[current->n] == 0);
     new_label->g += finish_time_penalties.get_penalty(current->t);
     new_label->f = new_label->g;
@@ -984,8 +1186,9 @@ void AStar::generate_end(Label* const current)
     }
 
     // Store the label.
+    const auto new_label_ref = get_latest_label_ref(new_label);
     label_pool_.commit_latest_label();
-    open_.push(new_label);
+    open_.push(new_label_ref);
 
     // Print.
 #ifdef DEBUG
@@ -1022,12 +1225,14 @@ AStar::Label* AStar::dominated<false>(Label* const new_label)
     debug_assert(data_.goal_penalties.empty());
 
     // Try to put in the new label.
-    auto [it, success] = frontier_without_resources_.try_emplace(NodeTime{new_label->nt}, new_label);
+    const auto new_label_ref = get_latest_label_ref(new_label);
+    auto [it, success] = frontier_without_resources_.try_emplace(NodeTime{new_label->nt}, new_label_ref);
 
     // Check for dominance if a label already exists.
     if (!success)
     {
-        auto existing_label = it->second;
+        const auto existing_label_ref = *it;
+        auto existing_label = get_label(existing_label_ref);
         debug_assert(existing_label->nt == new_label->nt);
         if (isLE(existing_label->f, new_label->f))
         {
@@ -1040,21 +1245,21 @@ AStar::Label* AStar::dominated<false>(Label* const new_label)
         else
         {
             // New label dominates existing label.
-            debug_assert(it == frontier_without_resources_.find(new_label->nt));
+            debug_assert(it == frontier_without_resources_.find(NodeTime{new_label->nt}));
             debug_assert(!isLE(existing_label->g, new_label->g));
 
             // Replace the existing label with the new label.
-            release_assert(existing_label->pqueue_index >= 0,
+            release_assert(open_.pqueue_index(existing_label_ref) >= 0,
                            "New label replacing an existing label that is not in the priority queue");
-            // if (existing_label->pqueue_index >= 0)
+            // if (open_.pqueue_index(existing_label_ref) >= 0)
             {
-                open_.update_pqueue_index(new_label, existing_label->pqueue_index);
+                open_.update_pqueue_index(new_label, open_.pqueue_index(existing_label_ref));
                 memcpy(existing_label, new_label, label_pool_.label_size());
-                open_.decrease_key(existing_label);
+                open_.decrease_key(existing_label_ref);
             }
             // else
             // {
-            //     debug_assert(existing_label->pqueue_index == -1);
+            //     debug_assert(open_.pqueue_index(existing_label) == -1);
             //     memcpy(existing_label, new_label, label_pool_.label_size());
             //     open_.push(existing_label);
             // }
@@ -1065,7 +1270,7 @@ AStar::Label* AStar::dominated<false>(Label* const new_label)
     {
         // Store the label.
         label_pool_.commit_latest_label();
-        open_.push(new_label);
+        open_.push(new_label_ref);
 
         // Not dominated.
         return new_label;
@@ -1096,8 +1301,9 @@ AStar::Label* AStar::dominated<true>(Label* const new_label)
     //         make_goal_state_string(&new_label->state_[0], nb_goal_penalties));
 
     // Check dominance.
-    auto& existing_labels = frontier_with_resources_[new_label->nt];
-    Label* store_in_existing_label = nullptr;
+    const auto nb_words = get_state_nb_words(nb_goal_penalties);
+    auto& existing_labels = frontier_with_resources_[NodeTime{new_label->nt}];
+    LabelRef store_in_existing_label = NO_LABEL;
 #ifdef DEBUG
     bool dominates = false;
 #endif
@@ -1105,15 +1311,15 @@ AStar::Label* AStar::dominated<true>(Label* const new_label)
     for (size_t idx = 0; idx < existing_labels.size();)
     {
         // Check if the new label is dominated by the existing label.
-        auto& existing_label = existing_labels[idx];
+        auto& existing_label_ref = existing_labels[idx];
+        const auto existing_label = get_label(existing_label_ref);
         {
             // Calculate the maximum cost of the existing label if it incurred the same penalties as the new label.
-            auto existing_label_potential_cost = existing_label->f;
-            for (Int idx = 0; idx < nb_goal_penalties; ++idx)
-                if (get_bitset(new_label->state_, idx) > get_bitset(existing_label->state_, idx))
-                {
-                    existing_label_potential_cost += goal_penalties[idx].cost;
-                }
+            const auto existing_label_potential_cost = add_crossing_penalties(existing_label->f,
+                                                                              new_label->state_,
+                                                                              existing_label->state_,
+                                                                              nb_words,
+                                                                              goal_penalties);
             // If the existing label still costs less than or equal to the new label, even after incurring these
             // penalties, then the new label is dominated.
             if (isLE(existing_label_potential_cost, new_label->f))
@@ -1125,28 +1331,27 @@ AStar::Label* AStar::dominated<true>(Label* const new_label)
 
         // Check if the existing label is dominated by the new label.
         {
-            auto new_label_potential_cost = new_label->f;
-            for (Int idx = 0; idx < nb_goal_penalties; ++idx)
-                if (get_bitset(existing_label->state_, idx) > get_bitset(new_label->state_, idx))
-                {
-                    new_label_potential_cost += goal_penalties[idx].cost;
-                }
+            const auto new_label_potential_cost = add_crossing_penalties(new_label->f,
+                                                                         existing_label->state_,
+                                                                         new_label->state_,
+                                                                         nb_words,
+                                                                         goal_penalties);
             if (isLE(new_label_potential_cost, existing_label->f))
             {
                 // If the existing label is not yet expanded, use its memory to store the new label.
-                debug_assert(nb_goal_penalties > 0 || existing_label->pqueue_index >= 0);
-                if (existing_label->pqueue_index >= 0)
+                debug_assert(nb_goal_penalties > 0 || open_.pqueue_index(existing_label_ref) >= 0);
+                if (open_.pqueue_index(existing_label_ref) >= 0)
                 {
-                    if (store_in_existing_label)
+                    if (store_in_existing_label != NO_LABEL)
                     {
-                        debug_assert(store_in_existing_label->pqueue_index >= 0);
-                        open_.erase(store_in_existing_label->pqueue_index);
+                        debug_assert(open_.pqueue_index(store_in_existing_label) >= 0);
+                        open_.erase(open_.pqueue_index(store_in_existing_label));
                     }
-                    store_in_existing_label = existing_label;
+                    store_in_existing_label = existing_label_ref;
                 }
 
                 // Delete the existing label from future dominance checks.
-                existing_label = existing_labels.back();
+                existing_label_ref = existing_labels.back();
                 existing_labels.pop_back(); // pop_back() invalidates end()-1 iterator so must use pointer in loop
 #ifdef DEBUG
                 dominates = true;
@@ -1160,25 +1365,27 @@ AStar::Label* AStar::dominated<true>(Label* const new_label)
     }
 
     // The new label is not dominated. Store the label.
-    if (store_in_existing_label)
+    if (store_in_existing_label != NO_LABEL)
     {
         // Replace the existing label with the new label.
-        debug_assert(isLE(new_label->f, store_in_existing_label->f));
-        debug_assert(store_in_existing_label->pqueue_index >= 0);
-        open_.update_pqueue_index(new_label, store_in_existing_label->pqueue_index);
-        memcpy(store_in_existing_label, new_label, label_pool_.label_size());
+        const auto existing_label = get_label(store_in_existing_label);
+        debug_assert(isLE(new_label->f, existing_label->f));
+        debug_assert(open_.pqueue_index(store_in_existing_label) >= 0);
+        open_.update_pqueue_index(new_label, open_.pqueue_index(store_in_existing_label));
+        memcpy(existing_label, new_label, label_pool_.label_size());
         open_.decrease_key(store_in_existing_label);
 
         existing_labels.push_back(store_in_existing_label);
-        return store_in_existing_label;
+        return existing_label;
     }
     else
     {
+        const auto new_label_ref = get_latest_label_ref(new_label);
         label_pool_.commit_latest_label();
-        open_.push(new_label);
-        debug_assert(new_label->pqueue_index >= 0);
+        open_.push(new_label_ref);
+        debug_assert(open_.pqueue_index(new_label_ref) >= 0);
 
-        existing_labels.push_back(new_label);
+        existing_labels.push_back(new_label_ref);
         return new_label;
     }
 #else
@@ -1206,12 +1413,99 @@ void AStar::preprocess_input()
     // Append the goal as a waypoint.
     debug_assert(earliest_goal_time <= latest_goal_time);
     waypoints.push_back(NodeTime{goal, earliest_goal_time});
+
+    // Overwrite the latest visit times of the map at the nodes of this run, restoring the nodes of the previous run.
+    for (const auto n : latest_visit_time_nodes_)
+    {
+        latest_visit_time_[n] = map_.latest_visit_time()[n];
+    }
+    latest_visit_time_nodes_.clear();
+    for (const auto& [n, t] : latest_visit_time)
+    {
+        latest_visit_time_[n] = t;
+        latest_visit_time_nodes_.push_back(n);
+    }
+}
+
+template<bool is_farkas>
+Cost AStar::lower_bound()
+{
+    // Get data.
+    const auto& [start,
+                 waypoints,
+                 goal,
+                 earliest_goal_time,
+                 latest_goal_time,
+                 cost_offset,
+                 latest_visit_time,
+                 edge_penalties,
+                 finish_time_penalties
+#ifdef USE_GOAL_CONFLICTS
+               , goal_penalties
+#endif
+    ] = data_;
+
+    // Every penalty is non-negative so the reduced cost of a path is at least the cost offset plus the
+    // earliest time it can visit every waypoint in order. Must be called after preprocessing the input.
+    debug_assert(!waypoints.empty() && waypoints.back().n == goal);
+    if constexpr (is_farkas)
+    {
+        return cost_offset;
+    }
+    Node n = start;
+    Time t = 0;
+    for (const auto& waypoint : waypoints)
+    {
+        t = std::max(t + heuristic_.get_h(waypoint.n)[n], waypoint.t);
+        n = waypoint.n;
+    }
+    return cost_offset + t;
 }
+template Cost AStar::lower_bound<false>();
+template Cost AStar::lower_bound<true>();
 
 template<bool is_farkas>
 Pair<Vector<NodeTime>, Cost> AStar::solve()
 {
     constexpr bool is_sipp = false;
+    TRACE_SCOPE("astar");
+
+    // Search from both the start and the goal if the path is long and has no waypoints or goal crossings. Farkas
+    // pricing has no step costs to bound the cost of the time before a node-time in the backward search.
+#ifdef USE_BIDIRECTIONAL_ASTAR
+    if constexpr (!is_farkas)
+    {
+        const auto& [start,
+                     waypoints,
+                     goal,
+                     earliest_goal_time,
+                     latest_goal_time,
+                     cost_offset,
+                     latest_visit_time,
+                     edge_penalties,
+                     finish_time_penalties
+#ifdef USE_GOAL_CONFLICTS
+                   , goal_penalties
+#endif
+        ] = data_;
+        const auto horizon = std::max<Time>(heuristic_.get_h(goal)[start], earliest_goal_time);
+        if (waypoints.size() == 1 &&
+#ifdef USE_GOAL_CONFLICTS
+            goal_penalties.empty() &&
+#endif
+            horizon >= BIDIRECTIONAL_MIN_HORIZON)
+        {
+            return bidirectional_search_.solve(start,
+                                               goal,
+                                               earliest_goal_time,
+                                               latest_goal_time,
+                                               cost_offset,
+                                               latest_visit_time_,
+                                               data_.edge_penalties,
+                                               finish_time_penalties);
+        }
+    }
+#endif
 
 #ifdef USE_GOAL_CONFLICTS
     if (!data_.goal_penalties.empty())
@@ -1233,6 +1527,7 @@ template<bool is_farkas>
 Pair<Vector<NodeTime>, Cost> AStar::solve_sipp()
 {
     constexpr bool is_sipp = true;
+    TRACE_SCOPE("astar_sipp");
 
 #ifdef USE_GOAL_CONFLICTS
     if (!data_.goal_penalties.empty())
@@ -1328,7 +1623,7 @@ Pair<Vector<NodeTime>, Cost> AStar::solve()
 
     // Reset.
     const auto nb_states = nb_goal_crossings;
-    label_pool_.reset(sizeof(Label) + (nb_states + CHAR_BIT - 1) / CHAR_BIT);
+    label_pool_.reset(sizeof(Label) + get_state_nb_words(nb_states) * sizeof(StateWord));
     open_.clear();
     if constexpr (has_resources)
     {
@@ -1364,6 +1659,14 @@ Pair<Vector<NodeTime>, Cost> AStar::solve()
         sipp_intervals_.create_intervals(waypoints, goal, edge_penalties, finish_time_penalties);
     }
 
+    // Index the node-times with penalties for free flight.
+#ifdef USE_FREE_FLIGHT_EXPANSION
+    if constexpr (!is_sipp && !is_farkas && !has_resources)
+    {
+        index_penalty_times();
+    }
+#endif
+
     // Solve up to but not including the last waypoint (goal).
     constexpr IntCost default_cost = is_farkas ? 0 : 1;
     if (waypoints.size() > 1)
@@ -1371,8 +1674,9 @@ Pair<Vector<NodeTime>, Cost> AStar::solve()
         while (!open_.empty())
         {
             // Get a label from priority queue.
-            const auto current = open_.top();
+            const auto current_ref = open_.top();
             open_.pop();
+            const auto current = get_label(current_ref);
 
             // Advance to the next waypoint.
             debug_assert(current->t <= waypoints[w].t);
@@ -1384,7 +1688,7 @@ Pair<Vector<NodeTime>, Cost> AStar::solve()
                 {
                     // Store the path.
                     Vector<NodeTime> path;
-                    for (auto l = current; l; l = l->parent)
+                    for (auto l = current; l; l = get_parent(l))
                     {
                         path.push_back(l->nt);
                     }
@@ -1427,7 +1731,7 @@ Pair<Vector<NodeTime>, Cost> AStar::solve()
                 // Stop if reached the last waypoint (goal).
                 if (w == static_cast<Waypoint>(waypoints.size() - 1))
                 {
-                    open_.push(current);
+                    open_.push(current_ref);
                     break;
                 }
             }
@@ -1435,11 +1739,11 @@ Pair<Vector<NodeTime>, Cost> AStar::solve()
             // Generate neighbours.
             if constexpr (is_sipp)
             {
-                generate_neighbours_sipp<default_cost, has_resources, false>(current, w, waypoints[w].t);
+                generate_neighbours_sipp<default_cost, has_resources, false>(current_ref, w, waypoints[w].t);
             }
             else
             {
-                generate_neighbours<default_cost, has_resources, false>(current, w, waypoints[w].t);
+                generate_neighbours<default_cost, has_resources, false>(current_ref, w, waypoints[w].t);
             }
         }
     }
@@ -1448,27 +1752,39 @@ Pair<Vector<NodeTime>, Cost> AStar::solve()
     while (!open_.empty())
     {
         // Get a label from priority queue.
-        const auto current = open_.top();
+        const auto current_ref = open_.top();
         open_.pop();
+        const auto current = get_label(current_ref);
 
         // Expand the neighbours of the current label or exit if the goal is reached.
         debug_assert(current->t <= latest_goal_time);
         if (current->n >= 0)
         {
+            // Jump to the goal if the rest of the path is free.
+#ifdef USE_FREE_FLIGHT_EXPANSION
+            if constexpr (!is_sipp && !is_farkas && !has_resources)
+            {
+                if (generate_free_flight(current_ref))
+                {
+                    continue;
+                }
+            }
+#endif
+
             // Generate neighbours.
             if constexpr (is_sipp)
             {
-                generate_neighbours_sipp<default_cost, has_resources, true>(current);
+                generate_neighbours_sipp<default_cost, has_resources, true>(current_ref);
             }
             else
             {
-                generate_neighbours<default_cost, has_resources, true>(current);
+                generate_neighbours<default_cost, has_resources, true>(current_ref);
             }
 
             // Generate to the end.
             if (current->n == goal && current->t >= earliest_goal_time)
             {
-                generate_end(current);
+                generate_end(current_ref);
             }
         }
         else
@@ -1480,8 +1796,8 @@ Pair<Vector<NodeTime>, Cost> AStar::solve()
             debug_assert(path.empty());
             if constexpr (is_sipp)
             {
-                auto prev = NodeTime{current->parent->nt};
-                for (auto l = current->parent; l; l = l->parent)
+                auto prev = NodeTime{get_parent(current)->nt};
+                for (auto l = get_parent(current); l; l = get_parent(l))
                 {
                     for (Time t = prev.t; t > l->t + 1;)
                     {
@@ -1494,7 +1810,7 @@ Pair<Vector<NodeTime>, Cost> AStar::solve()
             }
             else
             {
-                for (auto l = current->parent; l; l = l->parent)
+                for (auto l = get_parent(current); l; l = get_parent(l))
                 {
                     path.push_back(l->nt);
                 }
@@ -1503,7 +1819,7 @@ Pair<Vector<NodeTime>, Cost> AStar::solve()
 
             // Check.
 #ifdef DEBUG
-            for (auto l = current->parent; l; l = l->parent)
+            for (auto l = get_parent(current); l; l = get_parent(l))
             {
                 debug_assert(path[l->t].nt == l->nt);
             }
@@ -1652,7 +1968,7 @@ Pair<Vector<NodeTime>, Cost> AStar::calculate_cost(const Vector<Node>& input_pat
 
     // Reset.
     const auto nb_states = nb_goal_crossings;
-    label_pool_.reset(sizeof(Label) + (nb_states + CHAR_BIT - 1) / CHAR_BIT);
+    label_pool_.reset(sizeof(Label) + get_state_nb_words(nb_states) * sizeof(StateWord));
     open_.clear();
     frontier_without_resources_.clear();
     frontier_with_resources_.clear();
@@ -1684,8 +2000,9 @@ Pair<Vector<NodeTime>, Cost> AStar::calculate_cost(const Vector<Node>& input_pat
         while (!open_.empty())
         {
             // Get a label from priority queue.
-            const auto current = open_.top();
+            const auto current_ref = open_.top();
             open_.pop();
+            const auto current = get_label(current_ref);
 
             // Advance to the next waypoint.
             debug_assert(current->t <= waypoints[w].t);
@@ -1697,7 +2014,7 @@ Pair<Vector<NodeTime>, Cost> AStar::calculate_cost(const Vector<Node>& input_pat
                 {
                     // Store the path.
                     Vector<NodeTime> path;
-                    for (auto l = current; l; l = l->parent)
+                    for (auto l = current; l; l = get_parent(l))
                     {
                         path.push_back(l->nt);
                     }
@@ -1740,7 +2057,7 @@ Pair<Vector<NodeTime>, Cost> AStar::calculate_cost(const Vector<Node>& input_pat
                 // Stop if reached the last waypoint (goal).
                 if (w == static_cast<Waypoint>(waypoints.size() - 1))
                 {
-                    open_.push(current);
+                    open_.push(current_ref);
                     break;
                 }
             }
@@ -1753,33 +2070,33 @@ Pair<Vector<NodeTime>, Cost> AStar::calculate_cost(const Vector<Node>& input_pat
             const auto next_t = current->t + 1;
             if (const auto next_n = map_.get_north(current_n);
                 idx < static_cast<Int>(input_path.size()) && next_n == input_path[idx] &&
-                latest_visit_time[next_n] >= next_t && edge_costs.north < std::numeric_limits<Cost>::infinity())
+                latest_visit_time_[next_n] >= next_t && edge_costs.north < std::numeric_limits<Cost>::infinity())
             {
-                generate<is_sipp, has_resources, is_last_segment>(current, next_n, next_t, edge_costs.north, w, waypoint_time);
+                generate<is_sipp, has_resources, is_last_segment>(current_ref, next_n, next_t, edge_costs.north, w, waypoint_time);
             }
             if (const auto next_n = map_.get_south(current_n);
                 idx < static_cast<Int>(input_path.size()) && next_n == input_path[idx] &&
-                latest_visit_time[next_n] >= next_t && edge_costs.south < std::numeric_limits<Cost>::infinity())
+                latest_visit_time_[next_n] >= next_t && edge_costs.south < std::numeric_limits<Cost>::infinity())
             {
-                generate<is_sipp, has_resources, is_last_segment>(current, next_n, next_t, edge_costs.south, w, waypoint_time);
+                generate<is_sipp, has_resources, is_last_segment>(current_ref, next_n, next_t, edge_costs.south, w, waypoint_time);
             }
             if (const auto next_n = map_.get_east(current_n);
                 idx < static_cast<Int>(input_path.size()) && next_n == input_path[idx] &&
-                latest_visit_time[next_n] >= next_t && edge_costs.east < std::numeric_limits<Cost>::infinity())
+                latest_visit_time_[next_n] >= next_t && edge_costs.east < std::numeric_limits<Cost>::infinity())
             {
-                generate<is_sipp, has_resources, is_last_segment>(current, next_n, next_t, edge_costs.east, w, waypoint_time);
+                generate<is_sipp, has_resources, is_last_segment>(current_ref, next_n, next_t, edge_costs.east, w, waypoint_time);
             }
             if (const auto next_n = map_.get_west(current_n);
                 idx < static_cast<Int>(input_path.size()) && next_n == input_path[idx] &&
-                latest_visit_time[next_n] >= next_t && edge_costs.west < std::numeric_limits<Cost>::infinity())
+                latest_visit_time_[next_n] >= next_t && edge_costs.west < std::numeric_limits<Cost>::infinity())
             {
-                generate<is_sipp, has_resources, is_last_segment>(current, next_n, next_t, edge_costs.west, w, waypoint_time);
+                generate<is_sipp, has_resources, is_last_segment>(current_ref, next_n, next_t, edge_costs.west, w, waypoint_time);
             }
             if (const auto next_n = map_.get_wait(current_n);
                 idx < static_cast<Int>(input_path.size()) && next_n == input_path[idx] &&
-                latest_visit_time[next_n] >= next_t && edge_costs.wait < std::numeric_limits<Cost>::infinity())
+                latest_visit_time_[next_n] >= next_t && edge_costs.wait < std::numeric_limits<Cost>::infinity())
             {
-                generate<is_sipp, has_resources, is_last_segment>(current, next_n, next_t, edge_costs.wait, w, waypoint_time);
+                generate<is_sipp, has_resources, is_last_segment>(current_ref, next_n, next_t, edge_costs.wait, w, waypoint_time);
             }
 
             // Advance to the next node.
@@ -1791,8 +2108,9 @@ Pair<Vector<NodeTime>, Cost> AStar::calculate_cost(const Vector<Node>& input_pat
     while (!open_.empty())
     {
         // Get a label from priority queue.
-        const auto current = open_.top();
+        const auto current_ref = open_.top();
         open_.pop();
+        const auto current = get_label(current_ref);
 
         // Expand the neighbours of the current label or exit if the goal is reached.
         debug_assert(current->t <= latest_goal_time);
@@ -1804,39 +2122,39 @@ Pair<Vector<NodeTime>, Cost> AStar::calculate_cost(const Vector<Node>& input_pat
             const auto next_t = current->t + 1;
             if (const auto next_n = map_.get_north(current_n);
                 idx < static_cast<Int>(input_path.size()) && next_n == input_path[idx] &&
-                latest_visit_time[next_n] >= current->t + 1 && edge_costs.north < std::numeric_limits<Cost>::infinity())
+                latest_visit_time_[next_n] >= current->t + 1 && edge_costs.north < std::numeric_limits<Cost>::infinity())
             {
-                generate_last_segment<has_resources, is_sipp>(current, next_n, next_t, edge_costs.north);
+                generate_last_segment<has_resources, is_sipp>(current_ref, next_n, next_t, edge_costs.north);
             }
             if (const auto next_n = map_.get_south(current_n);
                 idx < static_cast<Int>(input_path.size()) && next_n == input_path[idx] &&
-                latest_visit_time[next_n] >= current->t + 1 && edge_costs.south < std::numeric_limits<Cost>::infinity())
+                latest_visit_time_[next_n] >= current->t + 1 && edge_costs.south < std::numeric_limits<Cost>::infinity())
             {
-                generate_last_segment<has_resources, is_sipp>(current, next_n, next_t, edge_costs.south);
+                generate_last_segment<has_resources, is_sipp>(current_ref, next_n, next_t, edge_costs.south);
             }
             if (const auto next_n = map_.get_east(current_n);
                 idx < static_cast<Int>(input_path.size()) && next_n == input_path[idx] &&
-                latest_visit_time[next_n] >= current->t + 1 && edge_costs.east < std::numeric_limits<Cost>::infinity())
+                latest_visit_time_[next_n] >= current->t + 1 && edge_costs.east < std::numeric_limits<Cost>::infinity())
             {
-                generate_last_segment<has_resources, is_sipp>(current, next_n, next_t, edge_costs.east);
+                generate_last_segment<has_resources, is_sipp>(current_ref, next_n, next_t, edge_costs.east);
             }
             if (const auto next_n = map_.get_west(current_n);
                 idx < static_cast<Int>(input_path.size()) && next_n == input_path[idx] &&
-                latest_visit_time[next_n] >= current->t + 1 && edge_costs.west < std::numeric_limits<Cost>::infinity())
+                latest_visit_time_[next_n] >= current->t + 1 && edge_costs.west < std::numeric_limits<Cost>::infinity())
             {
-                generate_last_segment<has_resources, is_sipp>(current, next_n, next_t, edge_costs.west);
+                generate_last_segment<has_resources, is_sipp>(current_ref, next_n, next_t, edge_costs.west);
             }
             if (const auto next_n = map_.get_wait(current_n);
                 idx < static_cast<Int>(input_path.size()) && next_n == input_path[idx] &&
-                latest_visit_time[next_n] >= current->t + 1 && edge_costs.wait < std::numeric_limits<Cost>::infinity())
+                latest_visit_time_[next_n] >= current->t + 1 && edge_costs.wait < std::numeric_limits<Cost>::infinity())
             {
-                generate_last_segment<has_resources, is_sipp>(current, next_n, next_t, edge_costs.wait);
+                generate_last_segment<has_resources, is_sipp>(current_ref, next_n, next_t, edge_costs.wait);
             }
 
             // Generate to the end.
             if (current->n == goal && current->t >= earliest_goal_time)
             {
-                generate_end(current);
+                generate_end(current_ref);
             }
         }
         else
@@ -1846,7 +2164,7 @@ Pair<Vector<NodeTime>, Cost> AStar::calculate_cost(const Vector<Node>& input_pat
 
             // Store the path.
             debug_assert(path.empty());
-            for (auto l = current->parent; l; l = l->parent)
+            for (auto l = get_parent(current); l; l = get_parent(l))
             {
                 path.push_back(l->nt);
             }
@@ -24,11 +24,13 @@ Author: Edward Lam <ed@ed-lam.com>
 #include "Coordinates.h"
 #include "Map.h"
 #include "LabelPool.h"
+#include "Frontier.h"
 #include "ReservationTable.h"
 #include "PriorityQueue.h"
 #include "Penalties.h"
 #include "Heuristic.h"
 #include "SIPPIntervals.h"
+#include "BidirectionalSearch.h"
 #include "boost/container/small_vector.hpp"
 
 template <class T, std::size_t N>
@@ -39,13 +41,21 @@ namespace TruffleHog
 
 class AStar
 {
-    // Label for main low-level search
+    // Label for main low-level search. In compact mode, the parent is a 32-bit index into the label pool and the
+    // position in the priority queue is stored by the priority queue.
     struct Label
     {
 #ifdef DEBUG
         size_t label_id;
 #endif
+#ifdef USE_COMPACT_LABELS
+        LabelIndex parent;
+#ifdef USE_RESERVATION_TABLE
+        Int reserves;
+#endif
+#else
         Label* parent;
+#endif
         Cost g;
         Cost f;
         union
@@ -57,18 +67,34 @@ class AStar
                 Time t;
             };
         };
+#ifndef USE_COMPACT_LABELS
 #ifdef USE_RESERVATION_TABLE
         Int reserves;
 #endif
         Int pqueue_index;
+#endif
         std::byte state_[0];
     };
-#ifdef DEBUG
+#if defined(USE_COMPACT_LABELS) && defined(DEBUG)
+    static_assert(sizeof(Label) == 5*8);
+#elif defined(USE_COMPACT_LABELS)
+    static_assert(sizeof(Label) == 4*8);
+#elif defined(DEBUG)
     static_assert(sizeof(Label) == 5*8 + 2*4);
 #else
     static_assert(sizeof(Label) == 4*8 + 2*4);
 #endif
 
+    // Reference to a stored label. In compact mode, a label is referenced by its index in the label pool so that its
+    // position in the priority queue is found without searching the label pool for the index.
+#ifdef USE_COMPACT_LABELS
+    using LabelRef = LabelIndex;
+    static constexpr LabelRef NO_LABEL = std::numeric_limits<LabelIndex>::max();
+#else
+    using LabelRef = Label*;
+    static constexpr LabelRef NO_LABEL = nullptr;
+#endif
+
     // Comparison of labels
     struct LabelCompare
     {
@@ -94,6 +120,238 @@ class AStar
     };
 
     // Priority queue holding labels
+#ifdef USE_COMPACT_LABELS
+    class AStarPriorityQueue
+    {
+        friend class AStar;
+
+        // The heap stores the f of each label next to its index so that comparisons only read the labels to break
+        // ties. The position of each label in the heap is stored separately by label index.
+        struct Entry
+        {
+            Cost f;
+            LabelIndex label;
+        };
+
+        LabelCompare cmp_;
+        const LabelPool& label_pool_;
+        Vector<Entry> elts_;
+        Vector<Int> pqueue_index_;
+        Int size_;
+
+      public:
+        // Constructors
+        template<class ...Args>
+        AStarPriorityQueue(const LabelPool& label_pool, Args... args) :
+            cmp_(args...),
+            label_pool_(label_pool),
+            elts_(8192),
+            pqueue_index_(8192),
+            size_(0)
+        {
+        }
+        AStarPriorityQueue(const AStarPriorityQueue&) = delete;
+        AStarPriorityQueue(AStarPriorityQueue&&) = delete;
+        AStarPriorityQueue& operator=(const AStarPriorityQueue&) = delete;
+        AStarPriorityQueue& operator=(AStarPriorityQueue&&) = delete;
+        ~AStarPriorityQueue() = default;
+
+        // Remove all elements
+        inline void clear()
+        {
+            size_ = 0;
+        }
+
+        // Add an element
+        void push(const LabelIndex label_idx)
+        {
+            if (size_ >= static_cast<Int>(elts_.size()))
+            {
+                elts_.resize(elts_.size() * 2);
+            }
+
+            if (label_idx >= pqueue_index_.size())
+            {
+                pqueue_index_.resize(std::max<size_t>(label_idx + 1, pqueue_index_.size() * 2));
+            }
+
+            auto index = size_;
+            elts_[index] = Entry{get_label(label_idx)->f, label_idx};
+            pqueue_index_[label_idx] = index;
+            size_++;
+            heapify_up(index);
+        }
+
+        // Remove the top element
+        LabelIndex pop()
+        {
+            debug_assert(size_ > 0);
+
+            auto label_idx = elts_[0].label;
+            pqueue_index_[label_idx] = -1;
+            size_--;
+
+            if (size_ > 0)
+            {
+                elts_[0] = elts_[size_];
+                pqueue_index_[elts_[0].label] = 0;
+                heapify_down(0);
+            }
+
+            return label_idx;
+        }
+
+        // Delete an element in the given position
+        void erase(const Int index)
+        {
+            debug_assert(size_ > 0);
+
+            --size_;
+            if (index == size_)
+            {
+                pqueue_index_[elts_[size_].label] = -1;
+            }
+            else
+            {
+                std::swap(elts_[index], elts_[size_]);
+                pqueue_index_[elts_[index].label] = index;
+                pqueue_index_[elts_[size_].label] = -1;
+
+                if (index == 0 || less(elts_[(index - 1) >> 1], elts_[index]))
+                {
+                    heapify_down(index);
+                }
+                else
+                {
+                    heapify_up(index);
+                }
+            }
+        }
+
+        // Retrieve the top element without removing it
+        inline LabelIndex top() const
+        {
+            debug_assert(size_ > 0);
+            return elts_[0].label;
+        }
+
+        // Get the number of elements stored within
+        inline auto size() const
+        {
+            return size_;
+        }
+
+        // Check whether the priority queue is empty
+        inline auto empty() const
+        {
+            return size() == 0;
+        }
+
+        // Get the comparison function
+        inline LabelCompare& cmp() { return cmp_; }
+        inline const LabelCompare& cmp() const { return cmp_; }
+
+        // Get the position of a label in the priority queue
+        inline Int pqueue_index(const LabelIndex label_idx) const
+        {
+            return pqueue_index_[label_idx];
+        }
+
+        // Checks.
+#ifdef DEBUG
+        void check_label(const LabelIndex label_idx)
+        {
+            const auto index = pqueue_index(label_idx);
+            debug_assert(-1 == index || (index < size_ && elts_[index].label == label_idx));
+        }
+#endif
+
+      protected:
+        // Nothing to do when a label is copied over another label because the position is stored by label index
+        inline void update_pqueue_index(Label*, const Int) {}
+
+        // Reprioritise an element up or down
+        void decrease_key(const LabelIndex label_idx)
+        {
+            const auto index = pqueue_index(label_idx);
+            debug_assert(0 <= index && index < size_);
+            elts_[index].f = get_label(label_idx)->f;
+            heapify_up(index);
+        }
+
+      private:
+        // Get a label from its index
+        inline Label* get_label(const LabelIndex label_idx) const
+        {
+            return reinterpret_cast<Label*>(label_pool_.get_label(label_idx));
+        }
+
+        // Compare two elements, only reading the labels if the f values are tied
+        inline bool less(const Entry& a, const Entry& b) const
+        {
+            return (a.f < b.f) ||
+                   (a.f == b.f && cmp_(get_label(a.label), get_label(b.label)));
+        }
+
+        // Reorder the subtree containing elts_[index]
+        void heapify_up(Int index)
+        {
+            debug_assert(index < size_);
+
+            while (index > 0)
+            {
+                const auto parent = (index - 1) >> 1;
+                if (less(elts_[index], elts_[parent]))
+                {
+                    swap(index, parent);
+                    index = parent;
+                }
+                else
+                {
+                    break;
+                }
+            }
+        }
+
+        // Reorders the subtree under elts_[index]
+        void heapify_down(Int index)
+        {
+            debug_assert(index < size_);
+
+            const auto first_leaf_index = size_ >> 1;
+            while (index < first_leaf_index)
+            {
+                // Find Better child.
+                const auto child1 = (index << 1) + 1;
+                const auto child2 = (index << 1) + 2;
+                const auto which = child2 < size_ && less(elts_[child2], elts_[child1]) ?
+                                   child2 :
+                                   child1;
+
+                // Swap child with parent if necessary.
+                if (less(elts_[which], elts_[index]))
+                {
+                    swap(index, which);
+                    index = which;
+                }
+                else
+                {
+                    break;
+                }
+            }
+        }
+
+        // Swap the positions of two labels
+        inline void swap(const Int index1, const Int index2)
+        {
+            debug_assert(index1 < size_ && index2 < size_);
+
+            std::swap(elts_[index1], elts_[index2]);
+            pqueue_index_[elts_[index1].label] = index1;
+            pqueue_index_[elts_[index2].label] = index2;
+        }
+    };
+#else
     class AStarPriorityQueue : public PriorityQueue<Label, LabelCompare>
     {
         friend class AStar;
@@ -130,6 +388,12 @@ class AStar
             label->pqueue_index = pqueue_index;
         }
 
+        // Get the position of a label in the priority queue
+        inline Int pqueue_index(const Label* const label) const
+        {
+            return label->pqueue_index;
+        }
+
         // Reprioritise an element up or down
         void decrease_key(Label* label)
         {
@@ -151,6 +415,7 @@ class AStar
         }
 #endif
     };
+#endif
 
   public:
     struct Data
@@ -164,15 +429,25 @@ class AStar
 
         // Costs
         Cost cost_offset;
-        Vector<Time> latest_visit_time;
+        HashTable<Node, Time> latest_visit_time;
         EdgePenalties edge_penalties;
         FinishTimePenalties finish_time_penalties;
 #ifdef USE_GOAL_CONFLICTS
         GoalPenalties goal_penalties;
 #endif
 
+        // Estimate of the bytes of memory used by the inputs
+        size_t memory_bytes() const;
+
         // Check if any cost is better
         bool can_be_better(const Data& previous_data);
+
+        // Get a lower bound on the cost of the optimal path from the optimal cost of a previous run
+        Cost lower_bound(const Data& previous_data, const Cost previous_cost);
+
+      private:
+        // Check if any cost other than the cost offset is better
+        bool penalties_can_be_better(const Data& previous_data);
     };
 
   private:
@@ -181,6 +456,8 @@ class AStar
 
     // Inputs for a run
     Data data_;
+    Vector<Time> latest_visit_time_;
+    Vector<Node> latest_visit_time_nodes_;
 
     // Solver data structures
     const Vector<IntCost>* h_node_to_waypoint_;
@@ -188,8 +465,8 @@ class AStar
     Heuristic heuristic_;
     LabelPool label_pool_;
     AStarPriorityQueue open_;
-    HashTable<NodeTime, Label*> frontier_without_resources_;
-    HashTable<NodeTime, SmallVector<Label*, 4>> frontier_with_resources_;
+    Frontier<LabelRef> frontier_without_resources_;
+    Frontier<SmallVector<LabelRef, 4>> frontier_with_resources_;
 #ifdef DEBUG
     size_t nb_labels_;
 #endif
@@ -197,6 +474,17 @@ class AStar
     // SIPP data structures
     SIPPIntervals sipp_intervals_;
 
+    // Bidirectional search data structures
+    BidirectionalSearch bidirectional_search_;
+
+    // Free-flight data structures
+#ifdef USE_FREE_FLIGHT_EXPANSION
+    Vector<Time> latest_penalty_time_;
+    Vector<Node> penalty_nodes_;
+    Vector<Node> free_flight_path_;
+    Frontier<bool> free_flight_failed_;
+#endif
+
   public:
     // Constructors
     AStar() = delete;
@@ -214,15 +502,61 @@ class AStar
 #endif
     auto& data() { return data_; }
     const auto& data() const { return data_; }
+    inline const auto& label_pool_statistics() const { return label_pool_.statistics(); }
+    inline void set_label_pool_block_size(const Int block_size) { label_pool_.set_block_size(block_size); }
+    inline size_t label_pool_bytes() const { return label_pool_.memory_bytes() + heuristic_.label_pool_bytes(); }
+    inline size_t heuristic_bytes() const { return heuristic_.table_bytes(); }
+    inline size_t frontier_bytes() const
+    {
+        return frontier_without_resources_.memory_bytes() +
+               frontier_with_resources_.memory_bytes() +
+#ifdef USE_FREE_FLIGHT_EXPANSION
+               free_flight_failed_.memory_bytes() +
+#endif
+               bidirectional_search_.memory_bytes();
+    }
+
+    // Free the memory of the label pools and the lower bounds not needed by the next run
+    inline void shrink_label_pools()
+    {
+        label_pool_.shrink();
+        heuristic_.shrink_label_pool();
+    }
+    inline void clear_heuristic_cache() { heuristic_.clear_cache(); }
+
+    // Free the memory of the frontiers, which are refilled by the next run
+    inline void release_frontiers()
+    {
+        frontier_without_resources_.release_memory();
+        frontier_with_resources_.release_memory();
+#ifdef USE_FREE_FLIGHT_EXPANSION
+        free_flight_failed_.release_memory();
+#endif
+        bidirectional_search_.release_memory();
+    }
 
     // Solve
     inline void compute_h(const Node goal) { heuristic_.get_h(goal); }
+    inline void set_shared_h(std::shared_ptr<HeuristicTables> shared_h)
+    {
+        heuristic_.set_shared_h(std::move(shared_h));
+    }
     void preprocess_input();
+    template<bool is_farkas>
+    Cost lower_bound();
     void before_solve();
     template<bool is_farkas>
     Pair<Vector<NodeTime>, Cost> solve();
     template<bool is_farkas>
     Pair<Vector<NodeTime>, Cost> solve_sipp();
+    inline void set_shared_edge_penalties(const EdgePenalties& edge_penalties)
+    {
+        sipp_intervals_.set_shared_edge_penalties(edge_penalties);
+    }
+    inline void clear_shared_edge_penalties()
+    {
+        sipp_intervals_.clear_shared_edge_penalties();
+    }
 
     // Debug
 #ifdef DEBUG
@@ -231,6 +565,39 @@ class AStar
 #endif
 
   private:
+    // Convert between labels and their references
+    inline Label* get_label(const LabelRef label_ref) const
+    {
+#ifdef USE_COMPACT_LABELS
+        return reinterpret_cast<Label*>(label_pool_.get_label(label_ref));
+#else
+        return label_ref;
+#endif
+    }
+    inline LabelRef get_latest_label_ref([[maybe_unused]] Label* const label) const
+    {
+#ifdef USE_COMPACT_LABELS
+        debug_assert(get_label(label_pool_.latest_label_index()) == label);
+        return label_pool_.latest_label_index();
+#else
+        return label;
+#endif
+    }
+
+    // Get and set the parent of a label
+    inline Label* get_parent(const Label* const label) const
+    {
+#ifdef USE_COMPACT_LABELS
+        return label->parent != NO_LABEL ? get_label(label->parent) : nullptr;
+#else
+        return label->parent;
+#endif
+    }
+    inline void set_parent(Label* const label, const LabelRef parent)
+    {
+        label->parent = parent;
+    }
+
     // Solve
     template<bool is_sipp, bool is_farkas, bool has_resources>
     Pair<Vector<NodeTime>, Cost> solve();
@@ -241,16 +608,16 @@ class AStar
 
     // Create intermediate label
     template<bool is_sipp, bool has_resources>
-    void generate_early_segment(Label* const current,
+    void generate_early_segment(const LabelRef current_ref,
                                 const Node next_n,
                                 const Time next_t,
                                 const Cost cost,
                                 const Waypoint w,
                                 const Time waypoint_time);
     template<bool is_sipp, bool has_resources>
-    void generate_last_segment(Label* const current, const Node next_n, const Time next_t, const Cost cost);
+    void generate_last_segment(const LabelRef current_ref, const Node next_n, const Time next_t, const Cost cost);
     template<bool is_sipp, bool has_resources, bool is_last_segment, class... WaypointArgs>
-    inline void generate(Label* const current,
+    inline void generate(const LabelRef current_ref,
                          const Node next_n,
                          const Time next_t,
                          const Cost cost,
@@ -258,23 +625,23 @@ class AStar
     {
         if constexpr (is_last_segment)
         {
-            generate_last_segment<is_sipp, has_resources>(current, next_n, next_t, cost, waypoint_args...);
+            generate_last_segment<is_sipp, has_resources>(current_ref, next_n, next_t, cost, waypoint_args...);
         }
         else
         {
-            generate_early_segment<is_sipp, has_resources>(current, next_n, next_t, cost, waypoint_args...);
+            generate_early_segment<is_sipp, has_resources>(current_ref, next_n, next_t, cost, waypoint_args...);
         }
     }
 
     // Expand next - time-expanded A*
     template<IntCost default_cost, bool has_resources, bool is_last_segment, class... WaypointArgs>
-    void generate_neighbours(Label* const current, WaypointArgs... waypoint_args);
+    void generate_neighbours(const LabelRef current_ref, WaypointArgs... waypoint_args);
 
     // Expand next - SIPP
     template<IntCost default_cost, bool has_resources, bool is_last_segment, class... WaypointArgs>
-    void generate_neighbours_sipp(Label* const current, WaypointArgs... waypoint_args);
+    void generate_neighbours_sipp(const LabelRef current_ref, WaypointArgs... waypoint_args);
     template<IntCost default_cost, bool has_resources, bool is_last_segment, class... WaypointArgs>
-    void generate_neighbours_one_interval_sipp(Label* const current,
+    void generate_neighbours_one_interval_sipp(const LabelRef current_ref,
                                                const Time wait_start,
                                                const Time wait_end,
                                                const Cost wait_penalty,
@@ -286,8 +653,14 @@ class AStar
                                                const SIPPInterval* wait_interval,
                                                WaypointArgs... waypoint_args);
 
+    // Expand next - jump along a penalty-free shortest path to the goal
+#ifdef USE_FREE_FLIGHT_EXPANSION
+    void index_penalty_times();
+    bool generate_free_flight(const LabelRef current_ref);
+#endif
+
     // Create end label
-    void generate_end(Label* const current);
+    void generate_end(const LabelRef current_ref);
 
     // Check if a label is dominated by an existing label
     template<bool has_resources>
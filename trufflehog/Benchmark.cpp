@@ -0,0 +1,243 @@
+/*
+This file is part of BCP-MAPF.
+
+BCP-MAPF is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+BCP-MAPF is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+Author: Edward Lam <ed@ed-lam.com>
+*/
+
+
+// Micro-benchmarks of the low-level solver data structures
+
+#include "Includes.h"
+#include "Coordinates.h"
+#include "ReservationTable.h"
+#include "Penalties.h"
+#include <chrono>
+#include <random>
+
+using namespace TruffleHog;
+
+template<class F>
+static double time_seconds(F&& f)
+{
+    const auto start_time = std::chrono::high_resolution_clock::now();
+    f();
+    const auto end_time = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double>(end_time - start_time).count();
+}
+
+// Reserve, query and unreserve paths of random walks over a grid
+static void benchmark_reservation_table()
+{
+    constexpr Int width = 256;
+    constexpr Int height = 256;
+    constexpr Node map_size = width * height;
+    constexpr Int nb_paths = 200;
+    constexpr Int nb_queries = 10'000'000;
+
+    println("Reservation table ({}x{} map, {} paths)", width, height, nb_paths);
+    println("{:>10} {:>14} {:>14} {:>14} {:>14} {:>8} {:>12}",
+            "Makespan", "Reserve (M/s)", "Query (M/s)", "Unreserve (M/s)", "Clear (ms)", "Pages", "Memory (MiB)");
+    for (const Time makespan : {100, 250, 500, 1000, 1500, 2000})
+    {
+        // Create random walks.
+        std::mt19937 rng(makespan);
+        std::uniform_int_distribution<Int> dir_dist(0, 4);
+        std::uniform_int_distribution<Node> node_dist(0, map_size - 1);
+        Vector<Vector<Node>> paths(nb_paths);
+        for (auto& path : paths)
+        {
+            Int x = node_dist(rng) % width;
+            Int y = node_dist(rng) / width;
+            path.resize(makespan);
+            for (Time t = 0; t < makespan; ++t)
+            {
+                switch (dir_dist(rng))
+                {
+                    case 0: y = std::max(y - 1, 0); break;
+                    case 1: y = std::min(y + 1, height - 1); break;
+                    case 2: x = std::min(x + 1, width - 1); break;
+                    case 3: x = std::max(x - 1, 0); break;
+                    default: break;
+                }
+                path[t] = y * width + x;
+            }
+        }
+        Vector<NodeTime> queries(nb_queries);
+        {
+            std::uniform_int_distribution<Time> time_dist(0, makespan - 1);
+            for (auto& nt : queries)
+            {
+                nt = NodeTime{node_dist(rng), time_dist(rng)};
+            }
+        }
+        const auto nb_reservations = static_cast<double>(nb_paths) * makespan;
+
+        // Run.
+        ReservationTable restab(map_size);
+        const auto reserve_time = time_seconds([&]()
+        {
+            for (const auto& path : paths)
+                for (Time t = 0; t < makespan; ++t)
+                {
+                    restab.reserve(NodeTime{path[t], t});
+                }
+        });
+        Int nb_reserved = 0;
+        const auto query_time = time_seconds([&]()
+        {
+            for (const auto nt : queries)
+            {
+                nb_reserved += restab.is_reserved(nt);
+            }
+        });
+        const auto nb_pages = restab.nb_pages();
+        const auto memory = restab.memory_size() / (1024.0 * 1024.0);
+        const auto unreserve_time = time_seconds([&]()
+        {
+            for (const auto& path : paths)
+                for (Time t = 0; t < makespan; ++t)
+                {
+                    restab.unreserve(NodeTime{path[t], t});
+                }
+        });
+        release_assert(restab.nb_free_pages() == nb_pages, "Reservation table is not empty after unreserving");
+        for (const auto& path : paths)
+            for (Time t = 0; t < makespan; ++t)
+            {
+                restab.reserve(NodeTime{path[t], t});
+            }
+        const auto clear_time = time_seconds([&]() { restab.clear_reservations(); });
+
+        // Print.
+        println("{:>10} {:>14.2f} {:>14.2f} {:>14.2f} {:>14.3f} {:>8} {:>12.2f}   ({} hits)",
+                makespan,
+                nb_reservations / reserve_time / 1e6,
+                nb_queries / query_time / 1e6,
+                nb_reservations / unreserve_time / 1e6,
+                clear_time * 1e3,
+                nb_pages,
+                memory,
+                nb_reserved);
+    }
+    println("");
+}
+
+// Add finish time penalties from goal-waiting cuts and compute the h values, compared against summing each
+// penalty over all earlier times and minimising over all later times
+static void benchmark_finish_time_penalties()
+{
+    constexpr Int nb_agents = 100;
+    constexpr Int nb_penalties = 200;
+
+    println("Finish time penalties ({} agents, {} penalties per agent)", nb_agents, nb_penalties);
+    println("{:>10} {:>16} {:>16} {:>10} {:>14}",
+            "Horizon", "Quadratic (ms)", "Linear (ms)", "Speedup", "Max h error");
+    for (const Time horizon : {100, 500, 1000, 2000, 5000})
+    {
+        // Create random penalties.
+        std::mt19937 rng(horizon);
+        std::uniform_int_distribution<Time> time_dist(0, horizon - 1);
+        std::uniform_real_distribution<Cost> cost_dist(0.0, 2.0);
+        Vector<Vector<Pair<Time, Cost>>> penalties(nb_agents);
+        for (auto& agent_penalties : penalties)
+            for (Int idx = 0; idx < nb_penalties; ++idx)
+            {
+                agent_penalties.emplace_back(time_dist(rng), cost_dist(rng));
+            }
+
+        // Run the quadratic reference.
+        Vector<Vector<Cost>> reference_h(nb_agents);
+        const auto quadratic_time = time_seconds([&]()
+        {
+            Vector<Cost> finish_time_penalties;
+            for (Agent a = 0; a < nb_agents; ++a)
+            {
+                finish_time_penalties.clear();
+                for (const auto& [t_max, cost] : penalties[a])
+                {
+                    if (t_max + 1 >= static_cast<Time>(finish_time_penalties.size()))
+                    {
+                        finish_time_penalties.resize(t_max + 1);
+                    }
+                    for (Time t = 0; t <= t_max; ++t)
+                    {
+                        finish_time_penalties[t] += cost;
+                    }
+                }
+                auto& h = reference_h[a];
+                h.resize(finish_time_penalties.size());
+                for (Time t = 0; t < static_cast<Time>(h.size()); ++t)
+                {
+                    h[t] = finish_time_penalties.size() - t;
+                    for (Time i = t; i < static_cast<Time>(finish_time_penalties.size()); ++i)
+                    {
+                        h[t] = std::min(h[t], i - t + finish_time_penalties[i]);
+                    }
+                }
+            }
+        });
+
+        // Run.
+        FinishTimePenalties finish_time_penalties;
+        Cost checksum = 0.0;
+        const auto linear_time = time_seconds([&]()
+        {
+            for (Agent a = 0; a < nb_agents; ++a)
+            {
+                finish_time_penalties.clear();
+                for (const auto& [t_max, cost] : penalties[a])
+                {
+                    finish_time_penalties.add(t_max, cost);
+                }
+                finish_time_penalties.before_solve();
+                checksum += finish_time_penalties.get_h(0);
+            }
+        });
+
+        // Check against the reference.
+        Cost max_error = 0.0;
+        for (Agent a = 0; a < nb_agents; ++a)
+        {
+            finish_time_penalties.clear();
+            for (const auto& [t_max, cost] : penalties[a])
+            {
+                finish_time_penalties.add(t_max, cost);
+            }
+            finish_time_penalties.before_solve();
+            for (Time t = 0; t < static_cast<Time>(reference_h[a].size()); ++t)
+            {
+                max_error = std::max(max_error, std::abs(finish_time_penalties.get_h(t) - reference_h[a][t]));
+            }
+        }
+
+        // Print.
+        println("{:>10} {:>16.3f} {:>16.3f} {:>10.1f} {:>14.2e}   (checksum {:.3f})",
+                horizon,
+                quadratic_time * 1e3,
+                linear_time * 1e3,
+                quadratic_time / linear_time,
+                max_error,
+                checksum);
+    }
+    println("");
+}
+
+int main()
+{
+    benchmark_reservation_table();
+    benchmark_finish_time_penalties();
+    return 0;
+}
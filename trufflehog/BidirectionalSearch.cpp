@@ -0,0 +1,266 @@
+/*
+This file is part of BCP-MAPF.
+
+BCP-MAPF is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+BCP-MAPF is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+Author: Edward Lam <ed@ed-lam.com>
+*/
+
+// #define PRINT_DEBUG
+
+#include "BidirectionalSearch.h"
+
+#define EPS (1e-6)
+#define isLT(x, y) ((x)-(y) < -(EPS))
+#define isGE(x, y) ((x)-(y) >= -(EPS))
+
+namespace TruffleHog
+{
+
+BidirectionalSearch::BidirectionalSearch(const Map& map, Heuristic& heuristic) :
+    map_(map),
+    heuristic_(heuristic),
+
+    forward_(map.size()),
+    backward_(map.size()),
+    forward_open_(),
+    backward_open_(),
+    best_cost_(0),
+    best_nt_()
+{
+}
+
+void BidirectionalSearch::generate(Frontier<Entry>& frontier,
+                                   Vector<QueueEntry>& open,
+                                   Frontier<Entry>& other_frontier,
+                                   const NodeTime nt,
+                                   const Node parent,
+                                   const Cost g,
+                                   const Cost f)
+{
+    // Check if cost-infeasible or no better than the best path found so far.
+    if (isGE(f, best_cost_))
+    {
+        return;
+    }
+
+    // Store the node-time if it is new or improved.
+    auto [entry, inserted] = frontier.try_emplace(nt, Entry{g, parent, false});
+    if (!inserted)
+    {
+        if (entry->closed || g >= entry->g)
+        {
+            return;
+        }
+        *entry = Entry{g, parent, false};
+    }
+    open.push_back(QueueEntry{f, g, nt});
+    std::push_heap(open.begin(), open.end(), QueueEntryCompare());
+
+    // Update the best path if the other direction has reached the node-time.
+    if (const auto other_entry = other_frontier.find(nt); other_entry && g + other_entry->g < best_cost_)
+    {
+        best_cost_ = g + other_entry->g;
+        best_nt_ = nt;
+    }
+}
+
+void BidirectionalSearch::remove_stale(Frontier<Entry>& frontier, Vector<QueueEntry>& open)
+{
+    while (!open.empty())
+    {
+        const auto& top = open.front();
+        const auto entry = frontier.find(top.nt);
+        debug_assert(entry);
+        if (!entry->closed && top.g == entry->g)
+        {
+            break;
+        }
+        std::pop_heap(open.begin(), open.end(), QueueEntryCompare());
+        open.pop_back();
+    }
+}
+
+Pair<Vector<NodeTime>, Cost> BidirectionalSearch::solve(const Node start,
+                                                        const Node goal,
+                                                        const Time earliest_goal_time,
+                                                        const Time latest_goal_time,
+                                                        const Cost cost_offset,
+                                                        const Vector<Time>& latest_visit_time,
+                                                        EdgePenalties& edge_penalties,
+                                                        const FinishTimePenalties& finish_time_penalties)
+{
+    constexpr IntCost default_cost = 1;
+
+    // Create output.
+    Pair<Vector<NodeTime>, Cost> output;
+    auto& path = output.first;
+    auto& path_cost = output.second;
+
+    // Reset. Only paths with negative cost are wanted.
+    forward_.clear();
+    backward_.clear();
+    forward_open_.clear();
+    backward_open_.clear();
+    best_cost_ = 0;
+    const auto& h_to_goal = heuristic_.get_h(goal);
+    const auto& h_from_start = heuristic_.get_h_from_start(start);
+
+    // Create the start of the forward search.
+    {
+        const auto h_node = std::max<Time>(h_to_goal[start], earliest_goal_time);
+        if (h_node > latest_goal_time)
+        {
+            return output;
+        }
+        const auto f = cost_offset + h_node + finish_time_penalties.get_h(h_node);
+        generate(forward_, forward_open_, backward_, NodeTime{start, 0}, -1, cost_offset, f);
+    }
+
+    // Create the ends of the backward search at every finish time. A path finishing at time t costs at least the cost
+    // offset plus t, so later finish times cannot have negative cost.
+    for (Time t = std::max<Time>(h_from_start[goal], earliest_goal_time);
+         t <= latest_goal_time && isLT(cost_offset + t, 0);
+         ++t)
+        if (t == 0 || latest_visit_time[goal] >= t)
+        {
+            const auto g = finish_time_penalties.get_penalty(t);
+            generate(backward_, backward_open_, forward_, NodeTime{goal, t}, -1, g, g + cost_offset + t);
+        }
+
+    // Expand the direction with the lower f until neither direction can improve the best path. The forward h is the
+    // time to the goal and the finish time penalties, and the backward h is the cost offset plus one for every
+    // timestep before the node-time.
+    while (true)
+    {
+        // Check if optimal.
+        remove_stale(forward_, forward_open_);
+        remove_stale(backward_, backward_open_);
+        if (forward_open_.empty() || backward_open_.empty() ||
+            isGE(forward_open_.front().f, best_cost_) ||
+            isGE(backward_open_.front().f, best_cost_))
+        {
+            break;
+        }
+
+        if (forward_open_.front().f <= backward_open_.front().f)
+        {
+            // Get a node-time from the forward priority queue.
+            const auto current = forward_open_.front();
+            std::pop_heap(forward_open_.begin(), forward_open_.end(), QueueEntryCompare());
+            forward_open_.pop_back();
+            forward_.find(current.nt)->closed = true;
+
+            // Expand in the five directions with a valid move.
+            const auto edge_costs = edge_penalties.get_edge_costs<default_cost>(current.nt);
+            const auto current_n = current.nt.n;
+            const auto next_t = current.nt.t + 1;
+            const auto moves = map_.get_moves(current_n);
+            for (Int d = 0; d <= Direction::WAIT; ++d)
+                if (moves & (1 << d))
+                {
+                    const auto next_n = current_n + map_.get_offset(static_cast<Direction>(d));
+                    if (latest_visit_time[next_n] >= next_t && edge_costs.d[d] < std::numeric_limits<Cost>::infinity())
+                    {
+                        const auto h_node = std::max<Time>(h_to_goal[next_n], earliest_goal_time - next_t);
+                        if (next_t + h_node <= latest_goal_time)
+                        {
+                            const auto g = current.g + edge_costs.d[d];
+                            const auto f = g + h_node + finish_time_penalties.get_h(next_t + h_node);
+                            generate(forward_, forward_open_, backward_, NodeTime{next_n, next_t}, current_n, g, f);
+                        }
+                    }
+                }
+        }
+        else
+        {
+            // Get a node-time from the backward priority queue.
+            const auto current = backward_open_.front();
+            std::pop_heap(backward_open_.begin(), backward_open_.end(), QueueEntryCompare());
+            backward_open_.pop_back();
+            backward_.find(current.nt)->closed = true;
+
+            // Expand to the node-times at the previous timestep with a valid move into the current node.
+            const auto current_n = current.nt.n;
+            const auto prev_t = current.nt.t - 1;
+            if (prev_t < 0)
+            {
+                continue;
+            }
+            for (Int d = 0; d <= Direction::WAIT; ++d)
+            {
+                const auto prev_n = current_n - map_.get_offset(static_cast<Direction>(d));
+                if (map_.can_move(prev_n, static_cast<Direction>(d)) &&
+                    (prev_t == 0 ? prev_n == start :
+                                   latest_visit_time[prev_n] >= prev_t && h_from_start[prev_n] <= prev_t))
+                {
+                    const NodeTime prev_nt{prev_n, prev_t};
+                    const auto cost = edge_penalties.get_edge_costs<default_cost>(prev_nt).d[d];
+                    if (cost < std::numeric_limits<Cost>::infinity())
+                    {
+                        const auto g = current.g + cost;
+                        generate(backward_, backward_open_, forward_, prev_nt, current_n, g, g + cost_offset + prev_t);
+                    }
+                }
+            }
+        }
+    }
+
+    // Store the path through the best meeting node-time.
+    if (best_cost_ < 0)
+    {
+        path_cost = best_cost_;
+        for (auto nt = best_nt_;;)
+        {
+            path.push_back(nt);
+            const auto parent = forward_.find(nt)->parent;
+            if (parent < 0)
+            {
+                break;
+            }
+            nt = NodeTime{parent, nt.t - 1};
+        }
+        std::reverse(path.begin(), path.end());
+        for (auto nt = best_nt_;;)
+        {
+            const auto parent = backward_.find(nt)->parent;
+            if (parent < 0)
+            {
+                break;
+            }
+            nt = NodeTime{parent, nt.t + 1};
+            path.push_back(nt);
+        }
+        debug_assert(path.front().n == start && path.back().n == goal);
+#ifdef DEBUG
+        for (Time t = 0; t < static_cast<Time>(path.size()); ++t)
+        {
+            debug_assert(path[t].t == t);
+        }
+#endif
+
+        // Print.
+        debugln("Bidirectional search found path with length {} and cost {} meeting at (({},{}),{})",
+                path.size(),
+                path_cost,
+                map_.get_x(best_nt_.n),
+                map_.get_y(best_nt_.n),
+                best_nt_.t);
+    }
+
+    // Done.
+    return output;
+}
+
+}
@@ -0,0 +1,125 @@
+/*
+This file is part of BCP-MAPF.
+
+BCP-MAPF is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+BCP-MAPF is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+Author: Edward Lam <ed@ed-lam.com>
+*/
+
+#ifndef TRUFFLEHOG_BIDIRECTIONALSEARCH_H
+#define TRUFFLEHOG_BIDIRECTIONALSEARCH_H
+
+#include "Includes.h"
+#include "Coordinates.h"
+#include "Map.h"
+#include "Frontier.h"
+#include "Penalties.h"
+#include "Heuristic.h"
+
+namespace TruffleHog
+{
+
+#define BIDIRECTIONAL_MIN_HORIZON 64
+
+class BidirectionalSearch
+{
+    // Search state of a node-time in one direction. The parent is the node at the previous timestep in the forward
+    // search and at the next timestep in the backward search.
+    struct Entry
+    {
+        Cost g;
+        Node parent;
+        bool closed;
+    };
+
+    // Node-time waiting in the priority queue of one direction. Entries are not removed when a node-time is
+    // improved, so an entry is stale if its node-time is closed or has a lower g.
+    struct QueueEntry
+    {
+        Cost f;
+        Cost g;
+        NodeTime nt;
+    };
+    struct QueueEntryCompare
+    {
+        inline bool operator()(const QueueEntry& a, const QueueEntry& b) const
+        {
+            return a.f > b.f || (a.f == b.f && a.g < b.g);
+        }
+    };
+
+    // Instance
+    const Map& map_;
+    Heuristic& heuristic_;
+
+    // Solver data structures
+    Frontier<Entry> forward_;
+    Frontier<Entry> backward_;
+    Vector<QueueEntry> forward_open_;
+    Vector<QueueEntry> backward_open_;
+    Cost best_cost_;
+    NodeTime best_nt_;
+
+  public:
+    // Constructors
+    BidirectionalSearch() = delete;
+    BidirectionalSearch(const Map& map, Heuristic& heuristic);
+    BidirectionalSearch(const BidirectionalSearch&) = delete;
+    BidirectionalSearch(BidirectionalSearch&&) = delete;
+    BidirectionalSearch& operator=(const BidirectionalSearch&) = delete;
+    BidirectionalSearch& operator=(BidirectionalSearch&&) = delete;
+    ~BidirectionalSearch() = default;
+
+    // Getters
+    inline size_t memory_bytes() const
+    {
+        return forward_.memory_bytes() + backward_.memory_bytes() +
+               vector_bytes(forward_open_) + vector_bytes(backward_open_);
+    }
+
+    // Free the memory of the frontiers
+    inline void release_memory()
+    {
+        forward_.release_memory();
+        backward_.release_memory();
+    }
+
+    // Solve from the start to the goal without intermediate waypoints or goal crossings, searching forward from
+    // the start and backward from the goal at every feasible finish time until the two searches prove optimality.
+    Pair<Vector<NodeTime>, Cost> solve(const Node start,
+                                       const Node goal,
+                                       const Time earliest_goal_time,
+                                       const Time latest_goal_time,
+                                       const Cost cost_offset,
+                                       const Vector<Time>& latest_visit_time,
+                                       EdgePenalties& edge_penalties,
+                                       const FinishTimePenalties& finish_time_penalties);
+
+  private:
+    // Store a node-time in one direction if it improves the node-time and update the best path through it
+    void generate(Frontier<Entry>& frontier,
+                  Vector<QueueEntry>& open,
+                  Frontier<Entry>& other_frontier,
+                  const NodeTime nt,
+                  const Node parent,
+                  const Cost g,
+                  const Cost f);
+
+    // Remove stale entries from the top of a priority queue
+    void remove_stale(Frontier<Entry>& frontier, Vector<QueueEntry>& open);
+};
+
+}
+
+#endif
@@ -0,0 +1,263 @@
+/*
+This file is part of BCP-MAPF.
+
+BCP-MAPF is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+BCP-MAPF is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+Author: Edward Lam <ed@ed-lam.com>
+*/
+
+#ifndef TRUFFLEHOG_FRONTIER_H
+#define TRUFFLEHOG_FRONTIER_H
+
+#include "Includes.h"
+#include "Coordinates.h"
+
+namespace TruffleHog
+{
+
+#define FRONTIER_DENSE_MEMORY (64 * 1024 * 1024)
+
+// Memory of the dense time layers, shared by all frontiers in the process up to a limit
+class FrontierMemory
+{
+    static inline size_t limit_ = FRONTIER_DENSE_MEMORY;
+    static inline size_t used_ = 0;
+
+  public:
+    // Getters
+    static inline size_t limit() { return limit_; }
+    static inline size_t used() { return used_; }
+
+    // Setters
+    static inline void set_limit(const size_t limit) { limit_ = limit; }
+
+    // Take memory for a time layer if the limit allows
+    static inline bool reserve(const size_t bytes)
+    {
+        if (used_ + bytes > limit_)
+        {
+            return false;
+        }
+        used_ += bytes;
+        return true;
+    }
+
+    // Return the memory of a time layer
+    static inline void release(const size_t bytes)
+    {
+        debug_assert(used_ >= bytes);
+        used_ -= bytes;
+    }
+};
+
+template<class T>
+class Frontier
+{
+    // Entries for the early timesteps are stored in a dense array indexed by time and node. Each time layer is
+    // allocated on first use from the memory shared by all frontiers, and the layers beyond the latest time of the
+    // previous search are freed when clearing. A slot is only valid if its stamp matches the current stamp so that
+    // clearing does not touch the slots. Entries beyond the dense timesteps are stored in a hash table. If a layer
+    // cannot be allocated, the dense timesteps end at the allocated layers until the next search so that every
+    // node-time stays in one place during a search.
+    struct Slot
+    {
+        uint32_t stamp = 0;
+        T value{};
+    };
+
+    Vector<UniquePtr<Slot[]>> layers_;
+    HashTable<NodeTime, T> overflow_;
+    Int map_size_;
+    Time dense_timesteps_;
+    Time max_time_;
+    uint32_t stamp_;
+    Int nb_dense_;
+
+  public:
+    // Constructors
+    Frontier(const Int map_size) :
+        layers_(),
+        overflow_(),
+        map_size_(map_size),
+        dense_timesteps_(map_size > 0 ? std::numeric_limits<Time>::max() : 0),
+        max_time_(-1),
+        stamp_(1),
+        nb_dense_(0)
+    {
+    }
+    Frontier(const Frontier&) = delete;
+    Frontier(Frontier&&) = delete;
+    Frontier& operator=(const Frontier&) = delete;
+    Frontier& operator=(Frontier&&) = delete;
+    ~Frontier()
+    {
+        release_layers(0);
+    }
+
+    // Getters
+    inline auto empty() const { return nb_dense_ == 0 && overflow_.empty(); }
+    inline auto dense_timesteps() const { return static_cast<Time>(layers_.size()); }
+    inline size_t memory_bytes() const
+    {
+        return layers_.size() * layer_bytes() + vector_bytes(layers_) + hash_table_bytes(overflow_);
+    }
+
+    // Insert a value if the node-time is not yet in the frontier. Returns a pointer to the value stored at the
+    // node-time and whether the value was inserted.
+    Pair<T*, bool> try_emplace(const NodeTime nt, const T& value)
+    {
+        if (auto slot = get_slot(nt))
+        {
+            if (slot->stamp == stamp_)
+            {
+                return {&slot->value, false};
+            }
+            slot->stamp = stamp_;
+            slot->value = value;
+            nb_dense_++;
+            return {&slot->value, true};
+        }
+        else
+        {
+            auto [it, success] = overflow_.try_emplace(nt, value);
+            return {&it->second, success};
+        }
+    }
+
+    // Get the value at a node-time, default constructing it if the node-time is not in the frontier
+    T& operator[](const NodeTime nt)
+    {
+        if (auto slot = get_slot(nt))
+        {
+            if (slot->stamp != stamp_)
+            {
+                slot->stamp = stamp_;
+                slot->value = T{};
+                nb_dense_++;
+            }
+            return slot->value;
+        }
+        else
+        {
+            return overflow_[nt];
+        }
+    }
+
+    // Get the value at a node-time or nullptr if the node-time is not in the frontier
+    T* find(const NodeTime nt)
+    {
+        if (nt.t < dense_timesteps_)
+        {
+            if (nt.t < static_cast<Time>(layers_.size()))
+            {
+                auto& slot = layers_[nt.t][nt.n];
+                if (slot.stamp == stamp_)
+                {
+                    return &slot.value;
+                }
+            }
+            return nullptr;
+        }
+        else
+        {
+            auto it = overflow_.find(nt);
+            return it != overflow_.end() ? &it->second : nullptr;
+        }
+    }
+
+    // Remove all entries
+    void clear()
+    {
+        // Free the layers beyond the latest time of the previous search.
+        release_layers(max_time_ + 1);
+        max_time_ = -1;
+        if (map_size_ > 0)
+        {
+            dense_timesteps_ = std::numeric_limits<Time>::max();
+        }
+
+        // Invalidate the dense slots by moving to the next stamp. Reset the stamps of every slot if the stamp wraps
+        // around.
+        if (nb_dense_ > 0)
+        {
+            nb_dense_ = 0;
+            if (++stamp_ == 0)
+            {
+                for (auto& layer : layers_)
+                    for (Int n = 0; n < map_size_; ++n)
+                    {
+                        layer[n].stamp = 0;
+                    }
+                stamp_ = 1;
+            }
+        }
+
+        // Clear the hash table.
+        if (!overflow_.empty())
+        {
+            overflow_.clear();
+        }
+    }
+
+    // Remove all entries and free the memory of the layers and the hash table
+    void release_memory()
+    {
+        clear();
+        release_layers(0);
+        overflow_ = HashTable<NodeTime, T>();
+    }
+
+  private:
+    // Get the bytes of a time layer
+    inline size_t layer_bytes() const
+    {
+        return sizeof(Slot) * map_size_;
+    }
+
+    // Get the slot of a node-time in the dense timesteps, allocating its time layer if necessary. Returns nullptr if
+    // the node-time is beyond the dense timesteps.
+    inline Slot* get_slot(const NodeTime nt)
+    {
+        debug_assert(0 <= nt.t);
+        if (nt.t >= dense_timesteps_)
+        {
+            return nullptr;
+        }
+        debug_assert(0 <= nt.n && nt.n < map_size_);
+        while (nt.t >= static_cast<Time>(layers_.size()))
+        {
+            if (!FrontierMemory::reserve(layer_bytes()))
+            {
+                dense_timesteps_ = layers_.size();
+                return nullptr;
+            }
+            layers_.push_back(std::make_unique<Slot[]>(map_size_));
+        }
+        max_time_ = std::max(max_time_, nt.t);
+        return &layers_[nt.t][nt.n];
+    }
+
+    // Free the layers from a time onwards
+    void release_layers(const Time t)
+    {
+        while (static_cast<Time>(layers_.size()) > t)
+        {
+            layers_.pop_back();
+            FrontierMemory::release(layer_bytes());
+        }
+    }
+};
+}
+
+#endif
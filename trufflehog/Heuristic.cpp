@@ -29,6 +29,8 @@ namespace TruffleHog
 Heuristic::Heuristic(const Map& map) :
     map_(map),
     h_(),
+    shared_h_(),
+    h_from_start_(),
     max_path_length_(-1),
     label_pool_(),
     open_(),
@@ -117,24 +119,15 @@ void Heuristic::generate(const Label* const current, const Node n)
 
 void Heuristic::generate_neighbours(const Label* const current)
 {
-    // Expand in four directions.
+    // Expand in the four directions with a valid move.
     const auto current_n = current->n;
-    if (const auto next_n = map_.get_north(current_n); map_[next_n])
-    {
-        generate(current, next_n);
-    }
-    if (const auto next_n = map_.get_south(current_n); map_[next_n])
-    {
-        generate(current, next_n);
-    }
-    if (const auto next_n = map_.get_east(current_n); map_[next_n])
-    {
-        generate(current, next_n);
-    }
-    if (const auto next_n = map_.get_west(current_n); map_[next_n])
-    {
-        generate(current, next_n);
-    }
+    const auto moves = map_.get_moves(current_n);
+    for (Int d = 0; d < Direction::WAIT; ++d)
+        if (moves & (1 << d))
+        {
+            const auto next_n = current_n + map_.get_offset(static_cast<Direction>(d));
+            generate(current, next_n);
+        }
 }
 
 void Heuristic::search(const Node goal, Vector<IntCost>& h)
@@ -171,23 +164,93 @@ void Heuristic::search(const Node goal, Vector<IntCost>& h)
     debugln("=======================================");
 }
 
+HeuristicTable Heuristic::compute_h(const Node goal)
+{
+    auto h = std::make_shared<Vector<IntCost>>();
+    search(goal, *h);
+    return h;
+}
+
 const Vector<IntCost>& Heuristic::get_h(const Node goal)
 {
     auto& h = h_[goal];
-    if (h.empty())
+    if (!h)
     {
-        // Compute the h values for this goal.
-        search(goal, h);
+        // Compute the h values for this goal or take them from another instance on the same map.
+        if (shared_h_)
+        {
+            auto& shared_h = (*shared_h_)[goal];
+            if (!shared_h)
+            {
+                shared_h = compute_h(goal);
+            }
+            h = shared_h;
+        }
+        else
+        {
+            h = compute_h(goal);
+        }
 
         // Get estimate of longest path length.
         {
-            auto it = std::max_element(h.begin(), h.end());
-            debug_assert(it != h.end());
+            auto it = std::max_element(h->begin(), h->end());
+            debug_assert(it != h->end());
             const auto new_max_path_length = MAX_PATH_LENGTH_FACTOR * *it;
             max_path_length_ = std::max(new_max_path_length, max_path_length_);
         }
     }
-    return h;
+    return *h;
+}
+
+const Vector<IntCost>& Heuristic::get_h_from_start(const Node start)
+{
+    // Every move can be reversed so the lower bound from the start is the lower bound to the start. These are stored
+    // separately to leave the estimate of the longest path length unchanged.
+    auto& h = h_from_start_[start];
+    if (!h)
+    {
+        h = compute_h(start);
+    }
+    return *h;
+}
+
+size_t Heuristic::table_bytes() const
+{
+    size_t bytes = hash_table_bytes(h_) + hash_table_bytes(h_from_start_);
+    for (const auto& [_, h] : h_)
+    {
+        bytes += vector_bytes(*h);
+    }
+    for (const auto& [_, h] : h_from_start_)
+    {
+        bytes += vector_bytes(*h);
+    }
+
+    // Count the shared lower bounds of the goals not in this instance.
+    if (shared_h_)
+    {
+        bytes += hash_table_bytes(*shared_h_);
+        for (const auto& [goal, h] : *shared_h_)
+            if (auto it = h_.find(goal); it == h_.end() || it->second != h)
+            {
+                bytes += vector_bytes(*h);
+            }
+    }
+    return bytes;
+}
+
+void Heuristic::clear_cache()
+{
+    // Stop sharing the lower bounds with other instances. The lower bounds of the goals of this instance stay
+    // alive, and the other lower bounds are freed unless another instance holds them.
+    if (shared_h_)
+    {
+        *shared_h_ = HeuristicTables();
+        shared_h_.reset();
+    }
+
+    // Free the lower bounds from the start nodes, which are recomputed when needed.
+    h_from_start_ = HeuristicTables();
 }
 
 }
@@ -29,6 +29,11 @@ Author: Edward Lam <ed@ed-lam.com>
 namespace TruffleHog
 {
 
+// Lower bounds from every node to a goal node, indexed by the goal node. The lower bounds of a goal are shared by
+// every instance on the same map.
+using HeuristicTable = std::shared_ptr<const Vector<IntCost>>;
+using HeuristicTables = HashTable<Node, HeuristicTable>;
+
 class Heuristic
 {
     // Label for heuristic
@@ -78,7 +83,9 @@ class Heuristic
     const Map& map_;
 
     // Lower bounds
-    HashTable<Node, Vector<IntCost>> h_;
+    HeuristicTables h_;
+    std::shared_ptr<HeuristicTables> shared_h_;
+    HeuristicTables h_from_start_;
     Time max_path_length_;
 
     // Solver data structures
@@ -101,10 +108,23 @@ class Heuristic
 
     // Getters
     inline auto max_path_length() const { return max_path_length_; }
+    inline size_t label_pool_bytes() const { return label_pool_.memory_bytes(); }
+    size_t table_bytes() const;
+
+    // Share the lower bounds with other instances on the same map
+    inline void set_shared_h(std::shared_ptr<HeuristicTables> shared_h) { shared_h_ = std::move(shared_h); }
 
     // Get the lower bound from every node to a goal node
     const Vector<IntCost>& get_h(const Node goal);
 
+    // Get the lower bound from a start node to every node
+    const Vector<IntCost>& get_h_from_start(const Node start);
+
+    // Free the memory not needed by the next search. The lower bounds to the goals of this instance are kept since
+    // every round of pricing needs them.
+    inline void shrink_label_pool() { label_pool_.shrink(); }
+    void clear_cache();
+
   private:
     // Check if a node has already been visited
     bool dominated(const Node n);
@@ -116,6 +136,7 @@ class Heuristic
 
     // Compute lower bound from every node to a goal node
     void search(const Node goal, Vector<IntCost>& h);
+    HeuristicTable compute_h(const Node goal);
 };
 
 }
@@ -58,6 +58,21 @@ using Pair = std::pair<T1, T2>;
 template <class T>
 using UniquePtr = std::unique_ptr<T>;
 
+// Estimate of the bytes of memory used by a vector
+template<class T>
+inline size_t vector_bytes(const Vector<T>& vec)
+{
+    return vec.capacity() * sizeof(T);
+}
+
+// Estimate of the bytes of memory used by a hash table. Every slot holds an entry and a byte of metadata, and the
+// table is at most 60% full.
+template<class Table>
+inline size_t hash_table_bytes(const Table& table)
+{
+    return table.size() * (sizeof(typename Table::value_type) + 1) * 10 / 6;
+}
+
 }
 
 #endif
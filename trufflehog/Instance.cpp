@@ -17,42 +17,184 @@ along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
 Author: Edward Lam <ed@ed-lam.com>
 */
 
-#include <fstream>
 #include "Instance.h"
+#include <charconv>
+#include <fcntl.h>
+#include <fstream>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace TruffleHog
 {
 
-struct AgentMapData
+// Instances converted to the binary format start with this string
+constexpr char BINARY_INSTANCE_MAGIC[8] = {'M', 'A', 'P', 'F', 'B', 'I', 'N', '1'};
+
+// Read-only file mapped into memory
+class MappedFile
 {
-    String map_path;
-    Position map_width;
-    Position map_height;
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+
+  public:
+    // Constructors
+    explicit MappedFile(const std::filesystem::path& path)
+    {
+        const auto fd = open(path.c_str(), O_RDONLY);
+        release_assert(fd >= 0, "Cannot open file {}", path.string());
+        struct stat file_stat;
+        release_assert(fstat(fd, &file_stat) == 0, "Cannot read size of file {}", path.string());
+        size_ = file_stat.st_size;
+        if (size_ > 0)
+        {
+            auto data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            release_assert(data != MAP_FAILED, "Cannot map file {} into memory", path.string());
+            madvise(data, size_, MADV_SEQUENTIAL);
+            data_ = static_cast<const char*>(data);
+        }
+        close(fd);
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile(MappedFile&&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile& operator=(MappedFile&&) = delete;
+    ~MappedFile()
+    {
+        if (data_)
+        {
+            munmap(const_cast<char*>(data_), size_);
+        }
+    }
+
+    // Getters
+    inline const char* begin() const { return data_; }
+    inline const char* end() const { return data_ + size_; }
+    inline size_t size() const { return size_; }
+};
+
+// Scanner over the text of a file
+class Scanner
+{
+    const char* it_;
+    const char* end_;
+
+  public:
+    // Constructors
+    Scanner(const char* begin, const char* end) : it_(begin), end_(end) {}
+
+    // Check if all the text is read
+    inline bool at_end() const
+    {
+        return it_ == end_;
+    }
+
+    // Get the next character without skipping whitespace
+    inline char peek() const
+    {
+        return it_ != end_ ? *it_ : '\0';
+    }
+    inline char get()
+    {
+        return it_ != end_ ? *it_++ : '\0';
+    }
+
+    // Skip spaces, tabs and line breaks
+    inline void skip_whitespace()
+    {
+        while (it_ != end_ && (*it_ == ' ' || *it_ == '\t' || *it_ == '\r' || *it_ == '\n'))
+        {
+            ++it_;
+        }
+    }
+
+    // Skip spaces and tabs without leaving the line
+    inline void skip_blanks()
+    {
+        while (it_ != end_ && (*it_ == ' ' || *it_ == '\t' || *it_ == '\r'))
+        {
+            ++it_;
+        }
+    }
+
+    // Read the rest of the line and move to the next line
+    std::string_view read_line()
+    {
+        const auto begin = it_;
+        while (it_ != end_ && *it_ != '\n')
+        {
+            ++it_;
+        }
+        std::string_view line(begin, it_ - begin);
+        if (it_ != end_)
+        {
+            ++it_;
+        }
+        return line;
+    }
+
+    // Read the next word
+    std::string_view read_token()
+    {
+        skip_whitespace();
+        const auto begin = it_;
+        while (it_ != end_ && *it_ != ' ' && *it_ != '\t' && *it_ != '\r' && *it_ != '\n')
+        {
+            ++it_;
+        }
+        return std::string_view(begin, it_ - begin);
+    }
+
+    // Read the next integer
+    Int read_int()
+    {
+        const auto token = read_token();
+        Int value = 0;
+        const auto [ptr, ec] = std::from_chars(token.data(), token.data() + token.size(), value);
+        release_assert(ec == std::errc() && ptr == token.data() + token.size(), "Expecting integer but found \"{}\"",
+                       token);
+        return value;
+    }
 };
 
+// Read a value from the binary format
+template<class T>
+static inline T read_value(const char*& it, const char* end)
+{
+    static_assert(std::is_trivially_copyable<T>::value);
+    release_assert(it + sizeof(T) <= end, "Binary instance file is truncated");
+    T value;
+    memcpy(&value, it, sizeof(T));
+    it += sizeof(T);
+    return value;
+}
+
+// Write a value in the binary format
+template<class T>
+static inline void write_value(std::ofstream& file, const T value)
+{
+    static_assert(std::is_trivially_copyable<T>::value);
+    file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
 void read_map(const std::filesystem::path& map_path, Map& map)
 {
     // Open map file.
-    std::ifstream map_file;
-    map_file.open(map_path, std::ios::in);
-    release_assert(map_file.good(), "Invalid map file {}", map_path.string());
+    MappedFile map_file(map_path);
+    Scanner scanner(map_file.begin(), map_file.end());
 
     // Read map.
-    {
-        char buf[1024];
-        map_file.getline(buf, 1024);
-        release_assert(strstr(buf, "type octile"), "Invalid map file format");
-    }
+    release_assert(scanner.read_line().find("type octile") != std::string_view::npos, "Invalid map file format");
 
     // Read map size.
     Position width = 0;
     Position height = 0;
-    String param;
     {
-        Int value;
         for (Int i = 0; i < 2; ++i)
         {
-            map_file >> param >> value;
+            const auto param = scanner.read_token();
+            const auto value = scanner.read_int();
             if (param == "width")
             {
                 width = value;
@@ -75,147 +217,242 @@ void read_map(const std::filesystem::path& map_path, Map& map)
     // Create map.
     map.resize(width, height);
 
-    // Read grid.
-    map_file >> param;
-    release_assert(param == "map", "Invalid map file header");
+    // Read grid. Start reading into the second row, second column of the grid.
+    release_assert(scanner.read_token() == "map", "Invalid map file header");
+    scanner.skip_blanks();
+    release_assert(scanner.get() == '\n', "Invalid map header");
+    for (Position y = 1; y < height - 1; ++y)
     {
-        auto c = static_cast<char>(map_file.get());
-        release_assert(map_file.good(), "Invalid map header");
-        if (c == '\r')
+        // Skip empty lines.
+        scanner.skip_whitespace();
+
+        // Read the cells of the row.
+        Node n = map.get_id(1, y);
+        for (Position x = 1; x < width - 1; ++x, ++n)
         {
-            c = static_cast<char>(map_file.get());
-            release_assert(map_file.good(), "Invalid map header");
+            scanner.skip_blanks();
+            const auto c = scanner.get();
+            release_assert(c != '\0' && c != '\n', "Fewer cells in the map file than its size");
+            if (c == '.')
+            {
+                map.set_passable(n);
+            }
         }
-        release_assert(c == '\n', "Invalid map header");
+
+        // Check the end of the row.
+        scanner.skip_blanks();
+        release_assert(scanner.peek() == '\n' || scanner.at_end(), "More cells in the map file than its size");
     }
-    Node n = width + 1; // Start reading into the second row, second column of the grid
-    while (true)
+    scanner.skip_whitespace();
+    release_assert(scanner.at_end(), "Unexpected number of cells");
+}
+
+// Read an instance from the binary format
+static void read_binary_instance(const MappedFile& file,
+                                 const Agent agent_limit,
+                                 MapCache* map_cache,
+                                 std::filesystem::path& map_path,
+                                 Map& map,
+                                 AgentsData& agents)
+{
+    // Read header.
+    auto it = file.begin() + sizeof(BINARY_INSTANCE_MAGIC);
+    const auto end = file.end();
+    const auto width = read_value<Position>(it, end);
+    const auto height = read_value<Position>(it, end);
+    release_assert(width > 2 && height > 2, "Invalid map size in binary instance file");
     {
-        auto c = static_cast<char>(map_file.get());
-        if (!map_file.good())
-        {
-            // eof
-            break;
-        }
+        const auto length = read_value<uint32_t>(it, end);
+        release_assert(it + length <= end, "Binary instance file is truncated");
+        map_path = String(it, length);
+        it += length;
+    }
+    const auto nb_agents = read_value<Agent>(it, end);
 
-        switch (c)
+    // Read the map from the bitset of passable cells or copy it from the maps read before.
+    const size_t size = static_cast<size_t>(width) * height;
+    const auto bitset = reinterpret_cast<const uint8_t*>(it);
+    release_assert(it + (size + 7) / 8 <= end, "Binary instance file is truncated");
+    it += (size + 7) / 8;
+    auto read_bitset = [&](Map& bitset_map)
+    {
+        bitset_map.resize(width, height);
+        for (Node n = 0; n < static_cast<Node>(size); ++n)
+            if (bitset[n / 8] & (1 << (n % 8)))
+            {
+                bitset_map.set_passable(n);
+            }
+    };
+    if (map_cache)
+    {
+        auto [cached, inserted] = map_cache->try_emplace(map_path.string());
+        if (inserted)
         {
-            case '\n':
-                if (auto c2 = map_file.peek(); map_file.good() && c2 != '\r' && c2 != '\n')
-                {
-                    n += 2;
-                }
-                break;
-            case ' ':
-            case '\t':
-            case '\r':
-                continue;
-            case '.':
-                release_assert(n < map.size(), "More cells in the map file than its size");
-                map.set_passable(n);
-                [[fallthrough]];
-            default:
-                n++;
-                break;
+            read_bitset(cached->second);
         }
+        map = cached->second;
+    }
+    else
+    {
+        read_bitset(map);
     }
-    n += width + 1; // Should be +2 but already counted a +1 from the previous \n
-    release_assert(n == map.size(), "Unexpected number of cells");
 
-    // Close file.
-    map_file.close();
+    // Read agents.
+    for (Agent a = 0; a < nb_agents && agents.size() < agent_limit; ++a)
+    {
+        const auto start_x = read_value<Position>(it, end);
+        const auto start_y = read_value<Position>(it, end);
+        const auto goal_x = read_value<Position>(it, end);
+        const auto goal_y = read_value<Position>(it, end);
+        release_assert(0 <= start_x && start_x < width && 0 <= start_y && start_y < height &&
+                       0 <= goal_x && goal_x < width && 0 <= goal_y && goal_y < height,
+                       "Agent {} is outside the map", a);
+        agents.add_agent(start_x, start_y, goal_x, goal_y, map);
+    }
 }
 
-Instance::Instance(const std::filesystem::path& scenario_path, const Agent agent_limit, const int time_spacing) :
+Instance::Instance(const std::filesystem::path& scenario_path,
+                   const Agent agent_limit,
+                   const int time_spacing,
+                   MapCache* map_cache) :
     scenario_path(scenario_path),
     map_path(),
     map(),
     agents(),
     time_spacing(time_spacing)
 {
+    // Open scenario file.
+    MappedFile scen_file(scenario_path);
+
     // Read agents.
-    Vector<AgentMapData> agents_map_data;
+    if (scen_file.size() >= sizeof(BINARY_INSTANCE_MAGIC) &&
+        memcmp(scen_file.begin(), BINARY_INSTANCE_MAGIC, sizeof(BINARY_INSTANCE_MAGIC)) == 0)
+    {
+        read_binary_instance(scen_file, agent_limit, map_cache, map_path, map, agents);
+    }
+    else
     {
-        // Open scenario file.
-        std::ifstream scen_file;
-        scen_file.open(scenario_path, std::ios::in);
-        release_assert(scen_file.good(), "Cannot find scenario file {}", scenario_path.string());
+        Scanner scanner(scen_file.begin(), scen_file.end());
 
         // Check file format.
-        {
-            char buf[1024];
-            scen_file.getline(buf, 1024);
-            release_assert(strstr(buf, "version 1"), "Expecting \"version 1\" scenario file format");
-        }
+        release_assert(scanner.read_line().find("version 1") != std::string_view::npos,
+                       "Expecting \"version 1\" scenario file format");
 
         // Read agents data.
+        std::string_view first_map_path;
+        while (agents.size() < agent_limit)
         {
-            Position start_x;
-            Position start_y;
-            Position goal_x;
-            Position goal_y;
-            Float tmp;
-            AgentMapData agent_map_data;
-            while (agents.size() < agent_limit &&
-                   (scen_file >> tmp >>
-                    agent_map_data.map_path >>
-                    agent_map_data.map_width >> agent_map_data.map_height >>
-                    start_x >> start_y >>
-                    goal_x >> goal_y >> tmp))
+            // Check for the end of the file.
+            scanner.skip_whitespace();
+            if (scanner.at_end())
             {
-                // Add padding.
-                agent_map_data.map_width += 2;
-                agent_map_data.map_height += 2;
-                start_x++;
-                start_y++;
-                goal_x++;
-                goal_y++;
-
-                // Read map.
-                if (map.empty())
-                {
-                    // Prepend the directory of the scenario file.
-                    map_path = scenario_path.parent_path().append(agent_map_data.map_path);
+                break;
+            }
+
+            // Read a line. The first and last columns are the bucket and the optimal cost.
+            scanner.read_token();
+            const auto agent_map_path = scanner.read_token();
+            const auto map_width = scanner.read_int() + 2; // Add padding.
+            const auto map_height = scanner.read_int() + 2;
+            const auto start_x = scanner.read_int() + 1;
+            const auto start_y = scanner.read_int() + 1;
+            const auto goal_x = scanner.read_int() + 1;
+            const auto goal_y = scanner.read_int() + 1;
+            scanner.read_token();
+
+            // Read map.
+            if (map.empty())
+            {
+                // Prepend the directory of the scenario file.
+                first_map_path = agent_map_path;
+                map_path = scenario_path.parent_path().append(String(agent_map_path));
 
-                    // Read map.
+                // Read map or copy it from the maps read before.
+                if (map_cache)
+                {
+                    auto [it, inserted] = map_cache->try_emplace(map_path.string());
+                    if (inserted)
+                    {
+                        read_map(map_path, it->second);
+                    }
+                    map = it->second;
+                }
+                else
+                {
                     read_map(map_path, map);
                 }
-
-                // Store.
-                agents.add_agent(start_x, start_y, goal_x, goal_y, map);
-                agents_map_data.push_back(agent_map_data);
             }
-        }
-        release_assert(agent_limit == std::numeric_limits<Int>::max() || agents.size() == agent_limit,
-                       "Scenario file contained {} agents. Not enough to read {} agents",
-                       agents.size(), agent_limit);
-        release_assert(!agents.empty(), "No agents in scenario file {}", scenario_path.string());
 
-        // Close file.
-        scen_file.close();
+            // Check.
+            const Agent a = agents.size();
+            release_assert(agent_map_path == first_map_path,
+                           "Agent {} uses a different map", a);
+            release_assert(map_width == map.width(),
+                           "Map width of agent {} does not match actual map size", a);
+            release_assert(map_height == map.height(),
+                           "Map height of agent {} does not match actual map size", a);
+            release_assert(0 < start_x && start_x < map.width() - 1 && 0 < start_y && start_y < map.height() - 1,
+                           "Agent {} starts outside the map", a);
+            release_assert(0 < goal_x && goal_x < map.width() - 1 && 0 < goal_y && goal_y < map.height() - 1,
+                           "Agent {} ends outside the map", a);
+
+            // Store.
+            agents.add_agent(start_x, start_y, goal_x, goal_y, map);
+        }
     }
+    release_assert(agent_limit == std::numeric_limits<Int>::max() || agents.size() == agent_limit,
+                   "Scenario file contained {} agents. Not enough to read {} agents",
+                   agents.size(), agent_limit);
+    release_assert(!agents.empty(), "No agents in scenario file {}", scenario_path.string());
 
     // Check.
     for (Agent a = 0; a < agents.size(); ++a)
     {
         const auto [start_id, goal_id, start_x, start_y, goal_x, goal_y] = agents[a];
-        const auto [map_path, map_width2, map_height2] = agents_map_data[a];
+        release_assert(map[start_id], "Agent {} starts at an obstacle", a);
+        release_assert(map[goal_id], "Agent {} ends at an obstacle", a);
+    }
+}
 
-        release_assert(map_path == agents_map_data[0].map_path,
-                       "Agent {} uses a different map");
-        release_assert(map_width2 == map.width(),
-                       "Map width of agent {} does not match actual map size", a);
-        release_assert(map_height2 == map.height(),
-                       "Map height of agent {} does not match actual map size", a);
+void Instance::write_binary(const std::filesystem::path& binary_path) const
+{
+    // Open file.
+    std::ofstream file(binary_path, std::ios::binary | std::ios::trunc);
+    release_assert(file.good(), "Cannot create binary instance file {}", binary_path.string());
 
-        const auto start_tile = start_y * map.width() + start_x;
-        release_assert(start_tile < map.size() && map[start_tile],
-                       "Agent {} starts at an obstacle", a);
+    // Write header.
+    file.write(BINARY_INSTANCE_MAGIC, sizeof(BINARY_INSTANCE_MAGIC));
+    write_value<Position>(file, map.width());
+    write_value<Position>(file, map.height());
+    const auto map_path_str = map_path.string();
+    write_value<uint32_t>(file, map_path_str.size());
+    file.write(map_path_str.data(), map_path_str.size());
+    write_value<Agent>(file, agents.size());
+
+    // Write the passable cells as a bitset.
+    {
+        Vector<uint8_t> bitset((map.size() + 7) / 8, 0);
+        for (Node n = 0; n < map.size(); ++n)
+            if (map[n])
+            {
+                bitset[n / 8] |= 1 << (n % 8);
+            }
+        file.write(reinterpret_cast<const char*>(bitset.data()), bitset.size());
+    }
 
-        const auto goal_tile = goal_y * map.width() + goal_x;
-        release_assert(goal_tile < map.size() && map[goal_tile],
-                       "Agent {} ends at an obstacle", a);
+    // Write agents.
+    for (Agent a = 0; a < agents.size(); ++a)
+    {
+        const auto [start_id, goal_id, start_x, start_y, goal_x, goal_y] = agents[a];
+        write_value<Position>(file, start_x);
+        write_value<Position>(file, start_y);
+        write_value<Position>(file, goal_x);
+        write_value<Position>(file, goal_y);
     }
+
+    // Close file.
+    file.close();
+    release_assert(!file.fail(), "Failed to write binary instance file {}", binary_path.string());
 }
 
 }
@@ -27,6 +27,9 @@ Author: Edward Lam <ed@ed-lam.com>
 namespace TruffleHog
 {
 
+// Maps read from file, indexed by the path to the map
+using MapCache = HashTable<String, Map>;
+
 struct Instance
 {
     std::filesystem::path scenario_path;
@@ -39,12 +42,15 @@ struct Instance
   public:
     // Constructors
     Instance() = default;
-    Instance(const std::filesystem::path& scenario_path, const Agent agent_limit = std::numeric_limits<Agent>::max(), const int time_spacing = 0);
+    Instance(const std::filesystem::path& scenario_path, const Agent agent_limit = std::numeric_limits<Agent>::max(), const int time_spacing = 0, MapCache* map_cache = nullptr);
     Instance(const Instance&) = default;
     Instance(Instance&&) = default;
     Instance& operator=(const Instance&) = default;
     Instance& operator=(Instance&&) = default;
     ~Instance() = default;
+
+    // Write the map and the agents in the binary format, which loads faster than the text files
+    void write_binary(const std::filesystem::path& binary_path) const;
 };
 
 }
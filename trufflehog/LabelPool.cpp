@@ -18,29 +18,74 @@ Author: Edward Lam <ed@ed-lam.com>
 */
 
 #include "LabelPool.h"
+#include <cstdlib>
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
 
-#define BLOCK_SIZE (10 * 1024 * 1024)
+#define HUGE_PAGE_SIZE (2 * 1024 * 1024)
 
 namespace TruffleHog
 {
 
-LabelPool::LabelPool() :
+// Round up to next multiple of 64
+static Int round_block_size(const Int block_size)
+{
+    return block_size % 64 ? block_size + (64 - block_size % 64) : block_size;
+}
+
+LabelPool::LabelPool(const Int block_size) :
     blocks_(),
+    block_size_(round_block_size(block_size)),
     block_idx_(0),
     byte_idx_(0),
-    label_size_(1)
+    label_size_(1),
+    labels_per_block_(block_size_ - 1),
+    label_idx_(0),
+    window_peak_blocks_(0),
+    window_nb_searches_(0),
+    stats_()
 {
-    debug_assert(BLOCK_SIZE % 8 == 0);
+    release_assert(block_size_ >= 64, "Label pool block size {} is too small", block_size);
+    debug_assert(block_size_ % 8 == 0);
 
     blocks_.reserve(50);
-    blocks_.push_back(std::make_unique<std::byte[]>(BLOCK_SIZE));
-    debug_assert(blocks_.back());
+    allocate_block();
+}
+
+LabelPool::~LabelPool()
+{
+    for (auto block : blocks_)
+    {
+        std::free(block);
+    }
+}
+
+void LabelPool::allocate_block()
+{
+    // Allocate without initializing the memory. Align blocks that are a multiple of the huge page size to huge pages
+    // and ask the kernel to back them with huge pages to reduce page faults and TLB misses.
+    const auto alignment = block_size_ % HUGE_PAGE_SIZE == 0 ? HUGE_PAGE_SIZE : 64;
+    auto block = reinterpret_cast<std::byte*>(std::aligned_alloc(alignment, block_size_));
+    release_assert(block, "Failed to allocate memory for labels");
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    if (alignment == HUGE_PAGE_SIZE)
+    {
+        madvise(block, block_size_, MADV_HUGEPAGE);
+    }
+#endif
+    blocks_.push_back(block);
+
+    // Update statistics.
+    stats_.nb_blocks = blocks_.size();
+    stats_.peak_blocks = std::max(stats_.peak_blocks, stats_.nb_blocks);
+    stats_.peak_bytes = std::max(stats_.peak_bytes, static_cast<size_t>(stats_.nb_blocks) * block_size_);
 }
 
 void* LabelPool::get_label_buffer()
 {
     // Move to the next block if there's no space in the current block.
-    if (byte_idx_ + label_size_ >= BLOCK_SIZE)
+    if (byte_idx_ + label_size_ >= block_size_)
     {
         block_idx_++;
         byte_idx_ = 0;
@@ -49,15 +94,15 @@ void* LabelPool::get_label_buffer()
     // Allocate new block if no space left.
     if (block_idx_ == static_cast<Int>(blocks_.size()))
     {
-        blocks_.push_back(std::make_unique<std::byte[]>(BLOCK_SIZE));
-        debug_assert(blocks_.back());
+        allocate_block();
     }
 
     // Find the memory to store the label.
     debug_assert(block_idx_ < static_cast<Int>(blocks_.size()));
-    debug_assert(byte_idx_ < BLOCK_SIZE);
+    debug_assert(byte_idx_ < block_size_);
     auto label = reinterpret_cast<void*>(&(blocks_[block_idx_][byte_idx_]));
     debug_assert(reinterpret_cast<uintptr_t>(label) % 8 == 0);
+    debug_assert(label_idx_ == static_cast<LabelIndex>(block_idx_ * labels_per_block_ + byte_idx_ / label_size_));
 
     // Done.
     return label;
@@ -66,18 +111,84 @@ void* LabelPool::get_label_buffer()
 void LabelPool::commit_latest_label()
 {
     debug_assert(block_idx_ < static_cast<Int>(blocks_.size()));
-    debug_assert(byte_idx_ < BLOCK_SIZE);
+    debug_assert(byte_idx_ < block_size_);
     debug_assert(label_size_ % 8 == 0);
     byte_idx_ += label_size_;
+    label_idx_++;
+    stats_.nb_labels++;
 }
 
 void LabelPool::reset(const Int label_size)
 {
+    // Update statistics of the previous search.
+    stats_.nb_searches++;
+    stats_.peak_labels = std::max(stats_.peak_labels, stats_.nb_labels);
+    stats_.total_labels += stats_.nb_labels;
+    stats_.nb_labels = 0;
+
+    // Periodically free the blocks that were not needed by any recent search.
+    window_peak_blocks_ = std::max(window_peak_blocks_, block_idx_ + 1);
+    if (++window_nb_searches_ >= LABEL_POOL_TRIM_INTERVAL)
+    {
+        trim();
+    }
+
+    // Reset.
     block_idx_ = 0;
     byte_idx_ = 0;
+    label_idx_ = 0;
     label_size_ = label_size % 8 ? // Round up to next multiple of 8
                   label_size + (8 - label_size % 8) :
                   label_size;
+
+    // A block holds the labels that end before the last byte of the block.
+    labels_per_block_ = (block_size_ - 1) / label_size_;
+}
+
+void LabelPool::set_block_size(const Int block_size)
+{
+    release_assert(block_size >= 64, "Label pool block size {} is too small", block_size);
+
+    // Free all blocks.
+    for (auto block : blocks_)
+    {
+        std::free(block);
+    }
+    blocks_.clear();
+
+    // Start again with one block of the new size.
+    block_size_ = round_block_size(block_size);
+    block_idx_ = 0;
+    byte_idx_ = 0;
+    label_idx_ = 0;
+    labels_per_block_ = (block_size_ - 1) / label_size_;
+    window_peak_blocks_ = 0;
+    window_nb_searches_ = 0;
+    allocate_block();
+}
+
+void LabelPool::trim()
+{
+    // Keep the blocks in use and the most blocks used by a search since the last trim.
+    const auto nb_keep = std::max(window_peak_blocks_, block_idx_ + 1);
+    while (static_cast<Int>(blocks_.size()) > nb_keep)
+    {
+        std::free(blocks_.back());
+        blocks_.pop_back();
+        stats_.nb_trimmed_blocks++;
+    }
+    stats_.nb_blocks = blocks_.size();
+
+    // Start a new window.
+    window_peak_blocks_ = 0;
+    window_nb_searches_ = 0;
+}
+
+void LabelPool::shrink()
+{
+    // Forget the blocks used by the earlier searches since the last trim.
+    window_peak_blocks_ = 0;
+    trim();
 }
 
 }
@@ -28,35 +28,87 @@ Author: Edward Lam <ed@ed-lam.com>
 namespace TruffleHog
 {
 
+#define LABEL_POOL_BLOCK_SIZE (10 * 1024 * 1024)
+#define LABEL_POOL_TRIM_INTERVAL 32
+
+// Index of a label in the pool
+using LabelIndex = uint32_t;
+
+// Statistics on the memory used by a label pool
+struct LabelPoolStatistics
+{
+    Int nb_searches;         // Number of searches (resets)
+    Int nb_blocks;           // Number of blocks currently allocated
+    Int peak_blocks;         // Maximum number of blocks allocated at once
+    Int nb_trimmed_blocks;   // Number of blocks freed by trimming
+    size_t peak_bytes;       // Maximum number of bytes allocated at once
+    size_t nb_labels;        // Number of labels in the latest search
+    size_t peak_labels;      // Maximum number of labels in a search
+    size_t total_labels;     // Number of labels over all searches
+};
+
 class LabelPool
 {
-    Vector<UniquePtr<std::byte[]>> blocks_;
+    Vector<std::byte*> blocks_;
+    Int block_size_;
     Int block_idx_;
     Int byte_idx_;
     Int label_size_;
+    Int labels_per_block_;
+    LabelIndex label_idx_;
+
+    // Blocks used in the searches since the last trim
+    Int window_peak_blocks_;
+    Int window_nb_searches_;
+
+    LabelPoolStatistics stats_;
 
   public:
     // Constructors
-    LabelPool();
+    LabelPool(const Int block_size = LABEL_POOL_BLOCK_SIZE);
     LabelPool(const LabelPool&) = delete;
     LabelPool(LabelPool&&) = delete;
     LabelPool& operator=(const LabelPool&) = delete;
     LabelPool& operator=(LabelPool&&) = delete;
-    ~LabelPool() = default;
+    ~LabelPool();
 
     // Getters
     inline Int label_size() const { return label_size_; }
+    inline Int block_size() const { return block_size_; }
+    inline const LabelPoolStatistics& statistics() const { return stats_; }
+    inline size_t memory_bytes() const { return blocks_.size() * static_cast<size_t>(block_size_); }
 
     // Get pointer to store a label
     void* get_label_buffer();
     void commit_latest_label();
 
+    // Get the index of the buffer returned by get_label_buffer until it is committed
+    inline LabelIndex latest_label_index() const { return label_idx_; }
+
+    // Get a label from its index
+    inline void* get_label(const LabelIndex label_idx) const
+    {
+        const auto block_idx = label_idx / labels_per_block_;
+        const auto byte_idx = (label_idx % labels_per_block_) * label_size_;
+        debug_assert(block_idx < blocks_.size());
+        return &blocks_[block_idx][byte_idx];
+    }
+
     // Reset all labels
     void reset(const Int label_size);
 
+    // Free all blocks and use blocks of a different size (only between searches)
+    void set_block_size(const Int block_size);
+
+    // Free the blocks above the most blocks used by a search since the last trim
+    void trim();
+
+    // Free the blocks above the blocks used by the latest search
+    void shrink();
+
   private:
     // Allocate
-    void allocate_blocks();
+    void allocate_block();
 };
 
 }
@@ -28,8 +28,13 @@ namespace TruffleHog
 
 class Map
 {
-    Vector<bool> passable_;  // Row-major matrix
+    // Each cell stores a bitmask of the valid moves out of it, with one bit per direction. The wait bit is set if
+    // the cell is passable, and a move bit is set if the cell and the destination cell are both passable.
+    using Moves = uint8_t;
+
+    Vector<Moves> moves_;  // Row-major matrix
     Vector<Time> latest_visit_time_;
+    std::array<Node, 5> offsets_ = {};
     Position width_ = 0;
     Position height_ = 0;
 
@@ -45,7 +50,7 @@ class Map
     // Getters
     inline Node size() const
     {
-        return passable_.size();
+        return moves_.size();
     }
     inline bool empty() const
     {
@@ -62,7 +67,21 @@ class Map
     inline bool operator[](const Node n) const
     {
         debug_assert(n < size());
-        return passable_[n];
+        return moves_[n] & (1 << Direction::WAIT);
+    }
+    inline Moves get_moves(const Node n) const
+    {
+        debug_assert(n < size());
+        return moves_[n];
+    }
+    inline bool can_move(const Node n, const Direction d) const
+    {
+        debug_assert(n < size());
+        return moves_[n] & (1 << d);
+    }
+    inline Node get_offset(const Direction d) const
+    {
+        return offsets_[d];
     }
     inline const Vector<Time>& latest_visit_time() const { return latest_visit_time_; }
     inline Node get_id(const Position x, const Position y) const
@@ -169,24 +188,67 @@ class Map
     void resize(const Position width, const Position height)
     {
         debug_assert(empty());
-        passable_.resize(width * height, false);
+        moves_.resize(width * height, 0);
         latest_visit_time_.resize(width * height, -1);
         width_ = width;
         height_ = height;
+        offsets_ = {-width, width, 1, -1, 0};
     }
     void set_passable(const Node n)
     {
         debug_assert(n < size());
-        passable_[n] = true;
+        moves_[n] |= 1 << Direction::WAIT;
         latest_visit_time_[n] = std::numeric_limits<Time>::max();
+        update_moves(n);
     }
     void set_obstacle(const Node n)
     {
         debug_assert(n < size());
-        passable_[n] = false;
+        moves_[n] &= ~(1 << Direction::WAIT);
         latest_visit_time_[n] = -1;
+        update_moves(n);
+    }
+
+  private:
+    // Update the moves between a cell and its neighbours
+    void update_moves(const Node n)
+    {
+        const auto x = get_x(n);
+        const auto y = get_y(n);
+        const auto update = [this](const Node from, const Direction d, const Node to)
+        {
+            if ((*this)[from] && (*this)[to])
+            {
+                moves_[from] |= 1 << d;
+            }
+            else
+            {
+                moves_[from] &= ~(1 << d);
+            }
+        };
+        if (y > 0)
+        {
+            update(n, Direction::NORTH, get_north(n));
+            update(get_north(n), Direction::SOUTH, n);
+        }
+        if (y < height_ - 1)
+        {
+            update(n, Direction::SOUTH, get_south(n));
+            update(get_south(n), Direction::NORTH, n);
+        }
+        if (x < width_ - 1)
+        {
+            update(n, Direction::EAST, get_east(n));
+            update(get_east(n), Direction::WEST, n);
+        }
+        if (x > 0)
+        {
+            update(n, Direction::WEST, get_west(n));
+            update(get_west(n), Direction::EAST, n);
+        }
     }
 
+  public:
     // Debug
     void print() const
     {
@@ -54,6 +54,8 @@ static_assert(sizeof(EdgeCosts) == 6 * 8);
 class EdgePenalties
 {
     HashTable<NodeTime, EdgeCosts> edge_penalties_;
+    Vector<NodeTime> modified_;
+    bool track_modified_ = false;
 
   public:
     // Constructors
@@ -107,6 +109,10 @@ class EdgePenalties
     // Create or return the outgoing edge penalties of a node-time
     inline EdgeCosts& get_edge_penalties(const NodeTime nt)
     {
+        if (track_modified_)
+        {
+            modified_.push_back(nt);
+        }
         return edge_penalties_[nt];
     }
     inline EdgeCosts& get_edge_penalties(const Node n, const Time t)
@@ -114,10 +120,22 @@ class EdgePenalties
         return get_edge_penalties(NodeTime{n, t});
     }
 
+    // Record the node-times whose penalties are accessed for modification from now on
+    inline void track_modified()
+    {
+        modified_.clear();
+        track_modified_ = true;
+    }
+    inline bool is_tracking_modified() const { return track_modified_; }
+    inline const Vector<NodeTime>& modified() const { return modified_; }
+    inline size_t memory_bytes() const { return hash_table_bytes(edge_penalties_) + vector_bytes(modified_); }
+
     // Clear for next run
     inline void clear()
     {
         edge_penalties_.clear();
+        modified_.clear();
+        track_modified_ = false;
     }
 
     // Nothing to do before solving
@@ -256,6 +274,7 @@ class GoalPenalties
     inline bool empty() const { return !size(); }
     inline const auto& data() const { return goal_penalties_; }
     const auto& operator[](const Int idx) const { return goal_penalties_[idx]; }
+    inline size_t memory_bytes() const { return vector_bytes(goal_penalties_); }
 
     // Clear for next run
     inline void clear()
@@ -294,7 +313,11 @@ class GoalPenalties
 // Penalties finishing at a particular time
 class FinishTimePenalties
 {
-    Vector<Cost> finish_time_penalties_;
+    // Penalties are added to a difference array, which holds the sum of the costs of the penalties for finishing at
+    // or before each time. The pending costs are moved into the penalties by a suffix sum on first read.
+    mutable Vector<Cost> finish_time_penalties_;
+    mutable Vector<Cost> pending_costs_;
+    mutable bool has_pending_costs_ = false;
     Vector<Cost> finish_time_h_;
 
   public:
@@ -307,21 +330,27 @@ class FinishTimePenalties
     ~FinishTimePenalties() noexcept = default;
 
     // Iterators
-    inline auto begin() { return finish_time_penalties_.begin(); }
-    inline auto begin() const { return finish_time_penalties_.begin(); }
-    inline auto end() { return finish_time_penalties_.end(); }
-    inline auto end() const { return finish_time_penalties_.end(); }
+    inline auto begin() { apply_pending_costs(); return finish_time_penalties_.begin(); }
+    inline auto begin() const { apply_pending_costs(); return finish_time_penalties_.cbegin(); }
+    inline auto end() { apply_pending_costs(); return finish_time_penalties_.end(); }
+    inline auto end() const { apply_pending_costs(); return finish_time_penalties_.cend(); }
 
     // Getters
     inline Time size() const { return finish_time_penalties_.size(); }
     inline bool empty() const { return !size(); }
-    inline const auto& data() const { return finish_time_penalties_; }
-    auto operator[](const Time t) const { return finish_time_penalties_[t]; }
+    inline const auto& data() const { apply_pending_costs(); return finish_time_penalties_; }
+    auto operator[](const Time t) const { apply_pending_costs(); return finish_time_penalties_[t]; }
+    inline size_t memory_bytes() const
+    {
+        return vector_bytes(finish_time_penalties_) + vector_bytes(pending_costs_) + vector_bytes(finish_time_h_);
+    }
 
-    // Clear for next run
+    // Clear for next run. The memory is kept for the next agent.
     inline void clear()
     {
         finish_time_penalties_.clear();
+        pending_costs_.clear();
+        has_pending_costs_ = false;
         finish_time_h_.clear();
     }
 
@@ -333,28 +362,28 @@ class FinishTimePenalties
         if (t_max + 1 >= size())
         {
             finish_time_penalties_.resize(t_max + 1);
+            pending_costs_.resize(t_max + 1);
         }
-        for (Time t = 0; t <= t_max; ++t)
-        {
-            finish_time_penalties_[t] += cost;
-        }
+        pending_costs_[t_max] += cost;
+        has_pending_costs_ = true;
     }
 
     // Sum up the penalties as a lower bound (h value)
     void before_solve()
     {
         debug_assert(finish_time_h_.empty());
-        finish_time_h_.resize(finish_time_penalties_.size());
-        for (Time t = 0; t < static_cast<Time>(finish_time_h_.size()); ++t)
+        apply_pending_costs();
+
+        // The cheapest way to finish from time t is to wait until some time i >= t and then finish with a penalty,
+        // or to wait until after all finish time penalties have elapsed and then finish at no cost. Compute the
+        // minimum over i with a suffix minimum of i + penalty(i).
+        const Time size = finish_time_penalties_.size();
+        finish_time_h_.resize(size);
+        Cost min_finish_time = size;
+        for (Time t = size - 1; t >= 0; --t)
         {
-            // Wait until after all finish time penalties have elapsed and then finish at no cost.
-            finish_time_h_[t] = finish_time_penalties_.size() - t;
-
-            // Wait until time i and then finish with a penalty.
-            for (Time i = t; i < static_cast<Time>(finish_time_penalties_.size()); ++i)
-            {
-                finish_time_h_[t] = std::min(finish_time_h_[t], i - t + finish_time_penalties_[i]);
-            }
+            min_finish_time = std::min<Cost>(min_finish_time, t + finish_time_penalties_[t]);
+            finish_time_h_[t] = min_finish_time - t;
         }
     }
 
@@ -365,8 +394,26 @@ class FinishTimePenalties
     }
     inline Cost get_penalty(const Time t) const
     {
+        apply_pending_costs();
         return t < static_cast<Time>(finish_time_penalties_.size()) ? finish_time_penalties_[t] : 0.0;
     }
+
+  private:
+    // Move the pending costs into the penalties
+    inline void apply_pending_costs() const
+    {
+        if (has_pending_costs_)
+        {
+            Cost cost = 0.0;
+            for (Time t = static_cast<Time>(pending_costs_.size()) - 1; t >= 0; --t)
+            {
+                cost += pending_costs_[t];
+                pending_costs_[t] = 0.0;
+                finish_time_penalties_[t] += cost;
+            }
+            has_pending_costs_ = false;
+        }
+    }
 };
 
 }
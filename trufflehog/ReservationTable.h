@@ -23,6 +23,7 @@ Author: Edward Lam <ed@ed-lam.com>
 #include "Includes.h"
 #include "Coordinates.h"
 #include <cmath>
+#include <cstring>
 
 #ifdef USE_RESERVATION_TABLE
 
@@ -31,53 +32,81 @@ namespace TruffleHog
 
 class ReservationTable
 {
-    char* table_;
-    Time timesteps_;
+    // Each time layer is a bitset of the nodes, stored in a page that is allocated on demand.
+    // Empty pages are returned to a pool for reuse by other time layers.
+    using Word = uint64_t;
+    static constexpr Int WORD_BITS = sizeof(Word) * CHAR_BIT;
+
+    Vector<Word*> layers_;
+    Vector<Int> layer_nb_reserved_;
+    Vector<UniquePtr<Word[]>> pages_;
+    Vector<Word*> free_pages_;
     const Node map_size_;
+    const Int page_size_;
+    HashTable<NodeTime, Int> overlaps_;
 
   public:
     // Constructors
     ReservationTable(const Node map_size) :
-        map_size_(map_size)
+        layers_(),
+        layer_nb_reserved_(),
+        pages_(),
+        free_pages_(),
+        map_size_(map_size),
+        page_size_((map_size + WORD_BITS - 1) / WORD_BITS),
+        overlaps_()
     {
-        timesteps_ = 4 * std::sqrt(map_size_);
-        table_ = static_cast<char*>(std::malloc(table_size(timesteps_)));
-        clear_reservations();
+        const Time timesteps = 4 * std::sqrt(map_size_);
+        layers_.reserve(timesteps);
+        layer_nb_reserved_.reserve(timesteps);
     }
     ReservationTable() = delete;
     ReservationTable(const ReservationTable&) = delete;
     ReservationTable(ReservationTable&&) = delete;
     ReservationTable& operator=(const ReservationTable&) = delete;
     ReservationTable& operator=(ReservationTable&&) = delete;
-    ~ReservationTable() noexcept
-    {
-        std::free(table_);
-    }
+    ~ReservationTable() noexcept = default;
 
-    // Check and make reservation
+    // Getters
     inline auto map_size() const
     {
         return map_size_;
     }
-    bool is_reserved(const NodeTime nt) const
+    inline Time timesteps() const
+    {
+        return layers_.size();
+    }
+    inline size_t nb_pages() const
+    {
+        return pages_.size();
+    }
+    inline size_t nb_free_pages() const
+    {
+        return free_pages_.size();
+    }
+    inline size_t memory_size() const
+    {
+        return pages_.size() * page_size_ * sizeof(Word) +
+               layers_.capacity() * (sizeof(Word*) + sizeof(Int));
+    }
+
+    // Check and make reservation
+    inline bool is_reserved(const NodeTime nt) const
     {
         // Check.
         debug_assert(0 <= nt.n && nt.n < map_size_);
         debug_assert(nt.t >= 0);
 
-        // Not reserved if beyond allocated memory.
-        if (nt.t >= timesteps_)
+        // Not reserved if the time layer is not allocated.
+        if (nt.t >= timesteps() || !layers_[nt.t])
         {
             return false;
         }
 
         // Get the bit.
-        const auto elem = static_cast<size_t>(nt.t) * map_size_ + nt.n;
-        const auto idx = elem / CHAR_BIT;
-        debug_assert(idx < table_size(timesteps_));
-        const char mask = 0b1 << (elem % CHAR_BIT);
-        const auto val = (table_[idx] & mask) != 0b0;
-        return val;
+        const auto layer = layers_[nt.t];
+        const Word mask = Word{1} << (nt.n % WORD_BITS);
+        return (layer[nt.n / WORD_BITS] & mask) != 0;
     }
     void reserve(const NodeTime nt)
     {
@@ -85,29 +114,30 @@ class ReservationTable
         debug_assert(0 <= nt.n && nt.n < map_size_);
         debug_assert(nt.t >= 0);
 
-        // Reallocate if not enough memory.
-        if (nt.t >= timesteps_)
+        // Get the time layer, allocating a page if needed.
+        if (nt.t >= timesteps())
+        {
+            layers_.resize(nt.t + 1, nullptr);
+            layer_nb_reserved_.resize(nt.t + 1, 0);
+        }
+        auto& layer = layers_[nt.t];
+        if (!layer)
         {
-            // Reallocate.
-            const auto new_timesteps = nt.t + 50;
-            table_ = static_cast<char*>(std::realloc(table_, table_size(new_timesteps)));
-            release_assert(table_, "Failed to reallocate memory for reservation table");
-
-            // Clear new section of memory.
-            const auto begin = table_ + table_size(timesteps_);
-            const auto end = table_ + table_size(new_timesteps);
-            memset(begin, 0, end - begin);
-
-            // Set size of memory.
-            timesteps_ = new_timesteps;
+            layer = get_page();
         }
 
-        // Set the bit.
-        const auto elem = static_cast<size_t>(nt.t) * map_size_ + nt.n;
-        const auto idx = elem / CHAR_BIT;
-        debug_assert(idx < table_size(timesteps_));
-        const char mask = 0b1 << (elem % CHAR_BIT);
-        table_[idx] |= mask;
+        // Set the bit or count another reservation if already set.
+        auto& word = layer[nt.n / WORD_BITS];
+        const Word mask = Word{1} << (nt.n % WORD_BITS);
+        if (word & mask)
+        {
+            ++overlaps_[nt];
+        }
+        else
+        {
+            word |= mask;
+            ++layer_nb_reserved_[nt.t];
+        }
     }
     inline void unreserve(const NodeTime nt)
     {
@@ -115,28 +145,57 @@ class ReservationTable
         debug_assert(0 <= nt.n && nt.n < map_size_);
         debug_assert(nt.t >= 0);
 
-        // Clear the bit.
-        if (nt.t < timesteps_)
+        // Remove one reservation. Clear the bit if it is the last one.
+        if (auto it = overlaps_.find(nt); it != overlaps_.end())
+        {
+            if (--it->second == 0)
+            {
+                overlaps_.erase(it);
+            }
+        }
+        else if (nt.t < timesteps() && layers_[nt.t])
         {
-            const auto elem = static_cast<size_t>(nt.t) * map_size_ + nt.n;
-            const auto idx = elem / CHAR_BIT;
-            debug_assert(idx < table_size(timesteps_));
-            const char mask = 0b1 << (elem % CHAR_BIT);
-            table_[idx] &= ~mask;
+            auto& layer = layers_[nt.t];
+            auto& word = layer[nt.n / WORD_BITS];
+            const Word mask = Word{1} << (nt.n % WORD_BITS);
+            if (word & mask)
+            {
+                word &= ~mask;
+
+                // Return the page to the pool if the time layer is empty.
+                if (--layer_nb_reserved_[nt.t] == 0)
+                {
+                    free_pages_.push_back(layer);
+                    layer = nullptr;
+                }
+            }
         }
     }
-    inline void clear_reservations()
+    void clear_reservations()
     {
-        memset(table_, 0, table_size(timesteps_));
+        for (Time t = 0; t < timesteps(); ++t)
+            if (auto& layer = layers_[t]; layer)
+            {
+                std::memset(layer, 0, page_size_ * sizeof(Word));
+                free_pages_.push_back(layer);
+                layer = nullptr;
+                layer_nb_reserved_[t] = 0;
+            }
+        overlaps_.clear();
     }
 
   private:
-    // Calculate the size of the reservation table in memory
-    inline size_t table_size(const Time timesteps) const
+    // Get an empty page from the pool or allocate a new one
+    Word* get_page()
     {
-        const auto tn_size = static_cast<size_t>(timesteps) * static_cast<size_t>(map_size_);
-        const auto size = (tn_size + CHAR_BIT - 1) / CHAR_BIT;
-        return size;
+        if (!free_pages_.empty())
+        {
+            auto page = free_pages_.back();
+            free_pages_.pop_back();
+            return page;
+        }
+        pages_.push_back(std::make_unique<Word[]>(page_size_));
+        return pages_.back().get();
     }
 };
 
@@ -20,6 +20,7 @@ Author: Edward Lam <ed@ed-lam.com>
 // #define PRINT_DEBUG
 
 #include "SIPPIntervals.h"
+#include "Trace.h"
 
 namespace TruffleHog
 {
@@ -29,18 +30,71 @@ SIPPIntervals::SIPPIntervals(const Map& map) :
     map_size_(map.size()),
 
     edge_penalties_(),
+    shared_edge_penalties_(),
+    agent_edge_penalties_(),
+    has_shared_edge_penalties_(false),
 
     intervals_(),
-    intervals_range_(map_size_ * 5 * 2),
-    clear_from_(),
-    clear_to_()
+    node_directory_(map_size_, -1),
+    directory_(),
+    penalty_nodes_(),
+    directory_d_(0)
 {
 }
 
-Pair<SIPPInterval*, SIPPInterval*> SIPPIntervals::get_intervals(const Node n, const Direction d)
+void SIPPIntervals::clear_directory()
 {
-    return {intervals_.data() + intervals_range_[2 * (n * 5 + d)],
-            intervals_.data() + intervals_range_[2 * (n * 5 + d) + 1]};
+    for (const auto n : penalty_nodes_)
+    {
+        node_directory_[n] = -1;
+    }
+    penalty_nodes_.clear();
+    directory_.clear();
+#ifdef DEBUG
+    for (const auto row : node_directory_)
+    {
+        debug_assert(row == -1);
+    }
+#endif
+}
+
+void SIPPIntervals::start_directory_entry(const Node n, const Direction d)
+{
+    // Check.
+    release_assert(intervals_.size() < std::numeric_limits<IntervalIndex>::max() - 10, "SIPP intervals overflow");
+    const IntervalIndex index = intervals_.size();
+
+    // Create a row for a new node after ending the intervals of all directions of the previous node.
+    if (penalty_nodes_.empty() || penalty_nodes_.back() != n)
+    {
+        finish_directory();
+        debug_assert(node_directory_[n] == -1);
+        node_directory_[n] = directory_.size();
+        penalty_nodes_.push_back(n);
+        directory_.resize(directory_.size() + 6);
+        directory_d_ = 0;
+    }
+
+    // Start the intervals of the direction, leaving the directions in between with no intervals.
+    debug_assert(directory_d_ <= d);
+    const auto row = node_directory_[n];
+    for (; directory_d_ <= d; ++directory_d_)
+    {
+        directory_[row + directory_d_] = index;
+    }
+}
+
+void SIPPIntervals::finish_directory()
+{
+    if (!penalty_nodes_.empty())
+    {
+        const IntervalIndex index = intervals_.size();
+        const auto row = node_directory_[penalty_nodes_.back()];
+        for (; directory_d_ <= 5; ++directory_d_)
+        {
+            directory_[row + directory_d_] = index;
+        }
+    }
 }
 
 // void SIPPIntervals::clear()
@@ -54,20 +108,103 @@ Pair<SIPPInterval*, SIPPInterval*> SIPPIntervals::get_intervals(const Node n, co
 //     edge_penalties_.emplace_back(TimeDirectionNode{nt.t, d, nt.n}, cost);
 // }
 
-void SIPPIntervals::create_intervals(const Vector<NodeTime>& waypoints,
-                                     const Node goal,
-                                     const EdgePenalties& edge_penalties,
-                                     const FinishTimePenalties& finish_time_penalties)
+static inline bool compare_edge_penalties(const Pair<TimeDirectionNode, Cost>& a,
+                                          const Pair<TimeDirectionNode, Cost>& b)
+{
+    return a.first < b.first;
+}
+
+void SIPPIntervals::flatten_edge_penalties(const EdgePenalties& edge_penalties,
+                                           Vector<Pair<TimeDirectionNode, Cost>>& output)
 {
-    // Reorder edge penalties.
-    edge_penalties_.clear();
     for (const auto& [nt, edge_penalty] : edge_penalties)
         if (map_[nt.n])
             for (Int d = 0; d < 5; ++d)
                 if (const auto penalty = edge_penalty.d[d]; penalty != 0)
                 {
-                    edge_penalties_.emplace_back(TimeDirectionNode{nt.t, static_cast<Direction>(d), nt.n}, penalty);
+                    output.emplace_back(TimeDirectionNode{nt.t, static_cast<Direction>(d), nt.n}, penalty);
                 }
+}
+
+void SIPPIntervals::set_shared_edge_penalties(const EdgePenalties& edge_penalties)
+{
+    TRACE_SCOPE("sipp_shared_penalties");
+    shared_edge_penalties_.clear();
+    flatten_edge_penalties(edge_penalties, shared_edge_penalties_);
+    std::sort(shared_edge_penalties_.begin(), shared_edge_penalties_.end(), compare_edge_penalties);
+    has_shared_edge_penalties_ = true;
+}
+
+void SIPPIntervals::clear_shared_edge_penalties()
+{
+    shared_edge_penalties_.clear();
+    has_shared_edge_penalties_ = false;
+}
+
+void SIPPIntervals::merge_shared_edge_penalties(const EdgePenalties& edge_penalties)
+{
+    // Get the final penalties of the edges modified for this agent.
+    agent_edge_penalties_.clear();
+    for (const auto nt : edge_penalties.modified())
+        if (map_[nt.n])
+        {
+            const auto it = edge_penalties.find(nt);
+            debug_assert(it != edge_penalties.end());
+            const auto& edge_penalty = it->second;
+            for (Int d = 0; d < 5; ++d)
+            {
+                agent_edge_penalties_.emplace_back(TimeDirectionNode{nt.t, static_cast<Direction>(d), nt.n},
+                                                   edge_penalty.d[d]);
+            }
+        }
+    std::sort(agent_edge_penalties_.begin(), agent_edge_penalties_.end(), compare_edge_penalties);
+    agent_edge_penalties_.erase(std::unique(agent_edge_penalties_.begin(),
+                                            agent_edge_penalties_.end(),
+                                            [](const auto& a, const auto& b) { return a.first.id == b.first.id; }),
+                                agent_edge_penalties_.end());
+
+    // Merge the modified penalties into the shared penalties in one pass. A modified penalty replaces the shared
+    // penalty of the same edge.
+    auto it = shared_edge_penalties_.begin();
+    const auto end = shared_edge_penalties_.end();
+    for (const auto& [tdn, penalty] : agent_edge_penalties_)
+    {
+        for (; it != end && it->first < tdn; ++it)
+        {
+            edge_penalties_.push_back(*it);
+        }
+        if (it != end && it->first.id == tdn.id)
+        {
+            ++it;
+        }
+        if (penalty != 0)
+        {
+            edge_penalties_.emplace_back(tdn, penalty);
+        }
+    }
+    edge_penalties_.insert(edge_penalties_.end(), it, end);
+}
+
+void SIPPIntervals::create_intervals(const Vector<NodeTime>& waypoints,
+                                     const Node goal,
+                                     const EdgePenalties& edge_penalties,
+                                     const FinishTimePenalties& finish_time_penalties)
+{
+    TRACE_SCOPE("sipp_intervals");
+
+    // Reorder edge penalties. If the edge penalties are modified from the shared penalties, the merged penalties
+    // are already sorted.
+    edge_penalties_.clear();
+    const auto is_sorted = has_shared_edge_penalties_ && edge_penalties.is_tracking_modified();
+    if (is_sorted)
+    {
+        merge_shared_edge_penalties(edge_penalties);
+    }
+    else
+    {
+        flatten_edge_penalties(edge_penalties, edge_penalties_);
+    }
+    const auto nb_sorted = static_cast<Int>(edge_penalties_.size());
 
     // Add extra intervals to correctly expand to the waypoints (which includes the goal).
     for (const auto nt : waypoints)
@@ -89,22 +226,22 @@ void SIPPIntervals::create_intervals(const Vector<NodeTime>& waypoints,
 
     // Create intervals from edge penalties.
     intervals_.clear();
-    memset(intervals_range_.data() + clear_from_, 0, sizeof(IntervalIndex) * (clear_to_ - clear_from_));
-#ifdef DEBUG
-    for (const auto x : intervals_range_)
-    {
-        debug_assert(x == 0);
-    }
-#endif
-    clear_from_ = 0;
-    clear_to_ = 0;
+    clear_directory();
     if (!edge_penalties_.empty())
     {
         // Sort edge penalties.
-        std::sort(edge_penalties_.begin(),
-                  edge_penalties_.end(),
-                  [](const Pair<TimeDirectionNode, Cost>& a, const Pair<TimeDirectionNode, Cost>& b)
-                  { return a.first < b.first; });
+        if (is_sorted)
+        {
+            std::sort(edge_penalties_.begin() + nb_sorted, edge_penalties_.end(), compare_edge_penalties);
+            std::inplace_merge(edge_penalties_.begin(),
+                               edge_penalties_.begin() + nb_sorted,
+                               edge_penalties_.end(),
+                               compare_edge_penalties);
+        }
+        else
+        {
+            std::sort(edge_penalties_.begin(), edge_penalties_.end(), compare_edge_penalties);
+        }
 #ifdef DEBUG
         for (Int idx = 0; idx < static_cast<Int>(edge_penalties_.size()) - 1; ++idx)
         {
@@ -175,15 +312,7 @@ void SIPPIntervals::create_intervals(const Vector<NodeTime>& waypoints,
             if (prev_interval_n != n || prev_interval_d != d)
             {
                 // Store the end index of the previous interval and the start index of the next interval.
-                release_assert(intervals_.size() < std::numeric_limits<IntervalIndex>::max() - 10,
-                               "SIPP intervals overflow");
-                if (prev_interval_d != Direction::INVALID)
-                {
-                    debug_assert(intervals_range_[2 * (prev_interval_n * 5 + prev_interval_d) + 1] == 0);
-                    intervals_range_[2 * (prev_interval_n * 5 + prev_interval_d) + 1] = intervals_.size();
-                }
-                debug_assert(intervals_range_[2 * (n * 5 + d)] == 0);
-                intervals_range_[2 * (n * 5 + d)] = intervals_.size();
+                start_directory_entry(n, static_cast<Direction>(d));
             }
             interval_n = n;
             interval_d = static_cast<Direction>(d);
@@ -217,23 +346,8 @@ void SIPPIntervals::create_intervals(const Vector<NodeTime>& waypoints,
 
         // Store the end index of the previous interval
         debug_assert(interval_d != Direction::INVALID);
-        debug_assert(intervals_range_[2 * (interval_n * 5 + interval_d) + 1] == 0);
-        intervals_range_[2 * (interval_n * 5 + interval_d) + 1] = intervals_.size();
-
-        // Store where to clear memory for the next iteration.
-        clear_from_ = 2 * (edge_penalties_.front().first.n * 5 + edge_penalties_.front().first.d);
-        clear_to_ = 2 * (interval_n * 5 + interval_d) + 1 + 1;
-        debug_assert(clear_from_ < clear_to_);
-#ifdef DEBUG
-        for (size_t idx = 0; idx < clear_from_; ++idx)
-        {
-            debug_assert(intervals_range_[idx] == 0);
-        }
-        for (size_t idx = clear_to_; idx < intervals_range_.size(); ++idx)
-        {
-            debug_assert(intervals_range_[idx] == 0);
-        }
-#endif
+        debug_assert(!penalty_nodes_.empty() && penalty_nodes_.back() == interval_n);
+        finish_directory();
 
         // Print.
 #ifdef PRINT_DEBUG
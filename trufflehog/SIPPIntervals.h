@@ -55,21 +55,24 @@ struct SIPPInterval
 
 class SIPPIntervals
 {
-#ifdef USE_PRIORITIZED_PLANNING_PRIMAL_HEURISTIC
     using IntervalIndex = uint32_t;
-#else
-    using IntervalIndex = uint16_t;
-#endif
 
     const Map& map_;
     Int map_size_;
 
     Vector<Pair<TimeDirectionNode, Cost>> edge_penalties_;
+    Vector<Pair<TimeDirectionNode, Cost>> shared_edge_penalties_;
+    Vector<Pair<TimeDirectionNode, Cost>> agent_edge_penalties_;
+    bool has_shared_edge_penalties_;
 
+    // The intervals of the nodes with penalties are indexed by a directory in compressed sparse row format. Each
+    // node with penalties has a row of six indices into the intervals, such that the intervals of direction d are
+    // between the d-th and (d+1)-th indices. Nodes without penalties have no row.
     Vector<SIPPInterval> intervals_;
-    Vector<IntervalIndex> intervals_range_;
-    size_t clear_from_;
-    size_t clear_to_;
+    Vector<Int> node_directory_;
+    Vector<IntervalIndex> directory_;
+    Vector<Node> penalty_nodes_;
+    Int directory_d_;
 
   public:
     // Constructors
@@ -85,12 +88,35 @@ class SIPPIntervals
     // void clear();
     // void add_edge_penalty(const NodeTime nt, const Direction d, const Cost cost);
 
+    // Store the edge penalties common to all agents in a round. The edge penalties of an agent that track their
+    // modifications from these shared penalties are then merged in without flattening and sorting all penalties.
+    void set_shared_edge_penalties(const EdgePenalties& edge_penalties);
+    void clear_shared_edge_penalties();
+
     // Solve
     void create_intervals(const Vector<NodeTime>& waypoints,
                           const Node goal,
                           const EdgePenalties& edge_penalties,
                           const FinishTimePenalties& finish_time_penalties);
-    Pair<SIPPInterval*, SIPPInterval*> get_intervals(const Node n, const Direction d);
+    inline Pair<SIPPInterval*, SIPPInterval*> get_intervals(const Node n, const Direction d)
+    {
+        const auto row = node_directory_[n];
+        if (row < 0)
+        {
+            return {intervals_.data(), intervals_.data()};
+        }
+        return {intervals_.data() + directory_[row + d], intervals_.data() + directory_[row + d + 1]};
+    }
+
+  private:
+    // Get the edge penalties
+    void flatten_edge_penalties(const EdgePenalties& edge_penalties, Vector<Pair<TimeDirectionNode, Cost>>& output);
+    void merge_shared_edge_penalties(const EdgePenalties& edge_penalties);
+
+    // Build the directory
+    void clear_directory();
+    void start_directory_entry(const Node n, const Direction d);
+    void finish_directory();
 };
 
 }
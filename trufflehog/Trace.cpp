@@ -0,0 +1,114 @@
+/*
+This file is part of BCP-MAPF.
+
+BCP-MAPF is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+BCP-MAPF is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+Author: Edward Lam <ed@ed-lam.com>
+*/
+
+
+#ifdef USE_TRACING
+
+#include "Trace.h"
+#include <chrono>
+#include <cstdio>
+
+#define TRACE_BUFFER_SIZE (64 * 1024)    // Number of scopes recorded before writing them to the file
+
+namespace TruffleHog
+{
+
+// File of the trace and the recorded scopes not yet written
+static FILE* trace_file = nullptr;
+static bool trace_file_empty = true;
+static Vector<TraceEvent> trace_events;
+
+// Get the time since the program started in microseconds
+static int64_t get_trace_time()
+{
+    static const auto origin = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - origin).count();
+}
+
+// Write the recorded scopes to the file and clear them
+static void flush_trace()
+{
+    debug_assert(trace_file);
+    for (const auto& [name, arg_name, arg, start, duration] : trace_events)
+    {
+        fmt::print(trace_file,
+                   "{}{{\"name\": \"{}\", \"cat\": \"bcp\", \"ph\": \"X\", \"ts\": {}, \"dur\": {}, \"pid\": 1, "
+                   "\"tid\": 1",
+                   trace_file_empty ? "" : ",\n",
+                   name,
+                   start,
+                   duration);
+        if (arg_name)
+        {
+            fmt::print(trace_file, ", \"args\": {{\"{}\": {}}}", arg_name, arg);
+        }
+        fmt::print(trace_file, "}}");
+        trace_file_empty = false;
+    }
+    trace_events.clear();
+}
+
+TraceScope::TraceScope(const char* name, const char* arg_name, const int64_t arg) :
+    name_(trace_file ? name : nullptr),
+    arg_name_(arg_name),
+    arg_(arg),
+    start_(trace_file ? get_trace_time() : 0)
+{
+}
+
+void TraceScope::end()
+{
+    if (name_)
+    {
+        if (trace_file)
+        {
+            trace_events.push_back(TraceEvent{name_, arg_name_, arg_, start_, get_trace_time() - start_});
+            if (trace_events.size() >= TRACE_BUFFER_SIZE)
+            {
+                flush_trace();
+            }
+        }
+        name_ = nullptr;
+    }
+}
+
+void start_trace(const String& path)
+{
+    release_assert(!trace_file, "Trace is already started");
+    trace_file = fopen(path.c_str(), "w");
+    release_assert(trace_file, "Failed to create trace file {}", path);
+    trace_file_empty = true;
+    trace_events.reserve(TRACE_BUFFER_SIZE);
+    fmt::print(trace_file, "{{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+}
+
+void stop_trace()
+{
+    if (trace_file)
+    {
+        flush_trace();
+        fmt::print(trace_file, "\n]}}\n");
+        fclose(trace_file);
+        trace_file = nullptr;
+        trace_events = Vector<TraceEvent>();
+    }
+}
+}
+
+#endif
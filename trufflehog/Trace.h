@@ -0,0 +1,85 @@
+/*
+This file is part of BCP-MAPF.
+
+BCP-MAPF is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+BCP-MAPF is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+Author: Edward Lam <ed@ed-lam.com>
+*/
+
+
+#ifndef TRUFFLEHOG_TRACE_H
+#define TRUFFLEHOG_TRACE_H
+
+#include "Includes.h"
+
+#ifdef USE_TRACING
+
+namespace TruffleHog
+{
+
+// Time span of a traced scope
+struct TraceEvent
+{
+    const char* name;        // Name of the scope
+    const char* arg_name;    // Name of the argument, or null if none
+    int64_t arg;             // Value of the argument
+    int64_t start;           // Start time in microseconds
+    int64_t duration;        // Duration in microseconds
+};
+
+// Record the time span from construction to destruction or to calling end()
+class TraceScope
+{
+    const char* name_;
+    const char* arg_name_;
+    int64_t arg_;
+    int64_t start_;
+
+  public:
+    // Constructors
+    TraceScope(const char* name, const char* arg_name = nullptr, const int64_t arg = 0);
+    TraceScope(const TraceScope&) = delete;
+    TraceScope(TraceScope&&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+    TraceScope& operator=(TraceScope&&) = delete;
+    inline ~TraceScope() { end(); }
+
+    // Finish the scope before it is destroyed
+    void end();
+};
+
+// Start recording scopes to a file in the Chrome trace event format. Scopes are only recorded between starting and
+// stopping.
+void start_trace(const String& path);
+
+// Write the remaining scopes and close the file
+void stop_trace();
+
+}
+
+#define TRACE_CONCAT_IMPL(x, y) x##y
+#define TRACE_CONCAT(x, y) TRACE_CONCAT_IMPL(x, y)
+#define TRACE_SCOPE(...) TruffleHog::TraceScope TRACE_CONCAT(trace_scope_, __LINE__)(__VA_ARGS__)
+#define TRACE_NAMED_SCOPE(var, ...) TruffleHog::TraceScope var(__VA_ARGS__)
+#define TRACE_END(var) var.end()
+
+#else
+
+#define TRACE_SCOPE(...)
+#define TRACE_NAMED_SCOPE(var, ...)
+#define TRACE_END(var)
+
+#endif
+
+#endif